@@ -0,0 +1,149 @@
+//========================================================//
+//  access.cpp                                            //
+//  Source file for table access counting and energy      //
+//                                                        //
+//  Per-access energies come from a simple SRAM model     //
+//  unless given per structure                            //
+//========================================================//
+#ifdef BP_ACCESS_STATS
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "access.h"
+#include "predictor.h"
+
+// SRAM energy model: an access drives 'width' bit lines whose length,
+// like the word lines, grows with the side of a square array of all the
+// structure's bits. Writes swing the bit lines fully. Tag comparisons
+// cost per compared bit.
+#define CELL_PJ 0.01      // per accessed bit
+#define WIRE_PJ 0.0004    // per accessed bit and bit of array side
+#define WRITE_FACTOR 1.2
+#define COMPARE_PJ 0.002  // per compared tag bit
+
+//------------------------------------//
+//      Access Data Structures        //
+//------------------------------------//
+
+typedef struct
+{
+  uint64_t reads;
+  uint64_t writes;
+  uint64_t tag_compares;
+  double read_pj;
+  double write_pj;
+} access_stats;
+
+bp_table access_tables[MAX_BP_TABLES];
+access_stats table_access[MAX_BP_TABLES];
+int num_access_tables = 0;
+uint64_t access_branches = 0;
+
+// Energies read from a file outlive the reinitialization of a run
+typedef struct
+{
+  char name[32];
+  double read_pj;
+  double write_pj;
+} energy_override;
+
+energy_override *energy_overrides = NULL;
+int num_energy_overrides = 0;
+
+//------------------------------------//
+//        Access Functions            //
+//------------------------------------//
+
+// Width of the tags of the YAGS caches, the only tagged structures
+//
+uint32_t tag_bits(const bp_table *t)
+{
+  return (t->assoc > 1) ? t->width - 2 : 0;
+}
+
+void init_access_stats()
+{
+  num_access_tables = declare_tables(access_tables);
+  memset(table_access, 0, sizeof(table_access));
+  access_branches = 0;
+  for (int t = 0; t < num_access_tables; t++)
+  {
+    bp_table *table = &access_tables[t];
+    // History registers are flip-flops without bit lines
+    double side = (table->entries > 1) ? sqrt((double)table->entries * table->width) : 0;
+    table_access[t].read_pj = table->width * (CELL_PJ + WIRE_PJ * side);
+    table_access[t].write_pj = WRITE_FACTOR * table_access[t].read_pj;
+    for (int i = 0; i < num_energy_overrides; i++)
+    {
+      if (!strcmp(energy_overrides[i].name, table->name))
+      {
+        table_access[t].read_pj = energy_overrides[i].read_pj;
+        table_access[t].write_pj = energy_overrides[i].write_pj;
+      }
+    }
+  }
+}
+
+void count_access(int table, uint32_t reads, uint32_t writes, uint32_t tag_compares)
+{
+  table_access[table].reads += reads;
+  table_access[table].writes += writes;
+  table_access[table].tag_compares += tag_compares;
+}
+
+void count_access_branch()
+{
+  access_branches++;
+}
+
+int read_access_energies(const char *path)
+{
+  FILE *f = fopen(path, "r");
+  if (f == NULL)
+    return 0;
+  char *line = NULL;
+  size_t line_len = 0;
+  int ok = 1;
+  while (ok && getline(&line, &line_len, f) != -1)
+  {
+    line[strcspn(line, "#\r\n")] = '\0';
+    if (strspn(line, " \t") == strlen(line))
+      continue;
+    energy_override o;
+    if (sscanf(line, "%31s %lf %lf", o.name, &o.read_pj, &o.write_pj) != 3)
+    {
+      ok = 0;
+      break;
+    }
+    energy_overrides = (energy_override *)realloc(energy_overrides,
+                                                  (num_energy_overrides + 1) * sizeof(energy_override));
+    energy_overrides[num_energy_overrides++] = o;
+  }
+  free(line);
+  fclose(f);
+  return ok;
+}
+
+void print_access_stats()
+{
+  double branches = access_branches ? (double)access_branches : 1;
+  double total_pj = 0;
+  printf("Accesses per branch:\n");
+  printf("  %-18s  %7s  %7s  %7s  %9s  %9s  %12s\n", "Structure", "Reads", "Writes", "Tags",
+         "Read pJ", "Write pJ", "Energy nJ");
+  for (int t = 0; t < num_access_tables; t++)
+  {
+    access_stats *a = &table_access[t];
+    double pj = a->reads * a->read_pj + a->writes * a->write_pj +
+                a->tag_compares * tag_bits(&access_tables[t]) * COMPARE_PJ;
+    total_pj += pj;
+    printf("  %-18s  %7.3f  %7.3f  %7.3f  %9.4f  %9.4f  %12.3f\n", access_tables[t].name,
+           a->reads / branches, a->writes / branches, a->tag_compares / branches, a->read_pj,
+           a->write_pj, pj / 1000);
+  }
+  printf("Energy:          %10.3f nJ (%.3f pJ per branch)\n", total_pj / 1000, total_pj / branches);
+}
+
+#endif
@@ -0,0 +1,40 @@
+//========================================================//
+//  access.h                                              //
+//  Header file for table access counting and energy      //
+//                                                        //
+//  Only compiled in with -DBP_ACCESS_STATS (make energy);//
+//  normal builds contain none of it                      //
+//========================================================//
+
+#ifndef ACCESS_H
+#define ACCESS_H
+
+#ifdef BP_ACCESS_STATS
+
+#include <stdint.h>
+
+// Start counting the accesses to the structures of the configured
+// predictor, numbered as in declare_tables
+//
+void init_access_stats();
+
+// Account the accesses of one trained conditional branch to structure
+// 'table'
+//
+void count_access(int table, uint32_t reads, uint32_t writes, uint32_t tag_compares);
+void count_access_branch();
+
+// Replace the modelled per-access energies of the structures listed in
+// 'path', one "<structure> <read pJ> <write pJ>" per line
+//
+// Returns True if Successful
+//
+int read_access_energies(const char *path);
+
+// Print the accesses per branch and the energy of every structure
+//
+void print_access_stats();
+
+#endif
+
+#endif
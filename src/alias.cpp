@@ -0,0 +1,135 @@
+//========================================================//
+//  alias.cpp                                             //
+//  Source file for the table aliasing analyzer           //
+//                                                        //
+//  Tracks the last branch to touch every table entry and //
+//  private counters per (table, entry, branch)           //
+//========================================================//
+#ifdef BP_ALIAS_STATS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "alias.h"
+#include "counter_map.h"
+
+//------------------------------------//
+//      Analyzer Data Structures      //
+//------------------------------------//
+
+typedef struct
+{
+  const char *name;
+  uint32_t entries;
+  uint32_t *last_pc;  // last branch to touch each entry
+  uint8_t *touched;
+  uint32_t occupied;  // entries touched at least once
+  uint64_t accesses;
+  uint64_t collisions; // accesses to an entry last touched by another branch
+  uint64_t constructive;
+  uint64_t destructive;
+  uint64_t destructive_mispredictions;
+} alias_table;
+
+#define MAX_ALIAS_TABLES 8
+
+alias_table alias_tables[MAX_ALIAS_TABLES];
+int num_alias_tables = 0;
+counter_map alias_counters;
+
+//------------------------------------//
+//        Analyzer Functions          //
+//------------------------------------//
+
+int register_alias_table(const char *name, uint32_t entries)
+{
+  if (num_alias_tables == 0)
+  {
+    init_counter_map(&alias_counters);
+  }
+  if (num_alias_tables == MAX_ALIAS_TABLES)
+  {
+    printf("Warning: too many tables for the aliasing analyzer!\n");
+    exit(1);
+  }
+  alias_table *t = &alias_tables[num_alias_tables];
+  t->name = name;
+  t->entries = entries;
+  t->last_pc = (uint32_t *)calloc(entries, sizeof(uint32_t));
+  t->touched = (uint8_t *)calloc(entries, sizeof(uint8_t));
+  t->occupied = 0;
+  t->accesses = 0;
+  t->collisions = 0;
+  t->constructive = 0;
+  t->destructive = 0;
+  t->destructive_mispredictions = 0;
+  return num_alias_tables++;
+}
+
+uint8_t *alias_private(int table, uint32_t index, uint32_t pc, uint8_t init)
+{
+  uint64_t key = ((uint64_t)index << 35) | ((uint64_t)pc << 3) | (uint64_t)table;
+  return find_counter(&alias_counters, key, init, 1);
+}
+
+void alias_access(int table, uint32_t index, uint32_t pc, int shared_correct, int private_correct,
+                  int mispredicted)
+{
+  alias_table *t = &alias_tables[table];
+  t->accesses++;
+  if (!t->touched[index])
+  {
+    t->touched[index] = 1;
+    t->occupied++;
+  }
+  else if (t->last_pc[index] != pc)
+  {
+    t->collisions++;
+    if (shared_correct && !private_correct)
+    {
+      t->constructive++;
+    }
+    else if (!shared_correct && private_correct)
+    {
+      t->destructive++;
+      t->destructive_mispredictions += mispredicted;
+    }
+  }
+  t->last_pc[index] = pc;
+}
+
+void print_alias_stats()
+{
+  printf("Aliasing:\n");
+  printf("  %-14s  %9s  %7s  %12s  %7s  %7s  %7s  %7s  %10s\n", "Table", "Entries", "Occupy%",
+         "Accesses", "Alias%", "Constr%", "Destr%", "Neutr%", "DestrMisp");
+  for (int i = 0; i < num_alias_tables; i++)
+  {
+    alias_table *t = &alias_tables[i];
+    double collisions = t->collisions > 0 ? (double)t->collisions : 1.0;
+    uint64_t neutral = t->collisions - t->constructive - t->destructive;
+    printf("  %-14s  %9u  %7.2f  %12llu  %7.2f  %7.2f  %7.2f  %7.2f  %10llu\n", t->name, t->entries,
+           100 * ((double)t->occupied / (double)t->entries),
+           (unsigned long long)t->accesses,
+           t->accesses > 0 ? 100 * ((double)t->collisions / (double)t->accesses) : 0.0,
+           100 * (t->constructive / collisions),
+           100 * (t->destructive / collisions),
+           100 * (neutral / collisions),
+           (unsigned long long)t->destructive_mispredictions);
+  }
+}
+
+void cleanup_alias_stats()
+{
+  for (int i = 0; i < num_alias_tables; i++)
+  {
+    free(alias_tables[i].last_pc);
+    free(alias_tables[i].touched);
+  }
+  if (num_alias_tables > 0)
+  {
+    free_counter_map(&alias_counters);
+  }
+  num_alias_tables = 0;
+}
+
+#endif
@@ -0,0 +1,42 @@
+//========================================================//
+//  alias.h                                               //
+//  Header file for the table aliasing analyzer           //
+//                                                        //
+//  Only compiled in with -DBP_ALIAS_STATS (make alias);  //
+//  normal builds contain none of it                      //
+//========================================================//
+
+#ifndef ALIAS_H
+#define ALIAS_H
+
+#ifdef BP_ALIAS_STATS
+
+#include <stdint.h>
+
+// Start tracking a prediction table of 'entries' entries
+//
+// Returns the table number used by the other functions
+//
+int register_alias_table(const char *name, uint32_t entries);
+
+// The interference-free counter the branch at PC 'pc' would own in
+// entry 'index' of a table, created in state 'init'
+//
+uint8_t *alias_private(int table, uint32_t index, uint32_t pc, uint8_t init);
+
+// Account an access by the branch at PC 'pc' to entry 'index' of a
+// table. The access aliases when the entry was last touched by another
+// branch; it is then constructive if the shared entry predicts correctly
+// where the private one would not, destructive in the opposite case and
+// neutral otherwise. 'mispredicted' tells whether the branch was
+// mispredicted overall.
+//
+void alias_access(int table, uint32_t index, uint32_t pc, int shared_correct, int private_correct,
+                  int mispredicted);
+
+void print_alias_stats();
+void cleanup_alias_stats();
+
+#endif
+
+#endif
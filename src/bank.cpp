@@ -0,0 +1,194 @@
+//========================================================//
+//  bank.cpp                                              //
+//  Source file for the banked table model                //
+//                                                        //
+//  A bundle holds the branches of one fetch block up to  //
+//  the first taken one; its lookups share the ports      //
+//========================================================//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bank.h"
+
+//------------------------------------//
+//       Bank Configuration           //
+//------------------------------------//
+
+const char *bankFallbackName[2] = {"static", "stall"};
+
+int numBanks = 0;     // Number of banks per table
+int bankPorts = 1;    // Number of read ports per bank
+int bundleWidth = 4;  // Number of conditional branches per bundle
+int fetchBlock = 32;  // Number of bytes fetched per cycle
+int bankFallback = BANK_STATIC;
+
+//------------------------------------//
+//       Bank Data Structures         //
+//------------------------------------//
+
+bp_table bank_tables[MAX_BP_TABLES];
+int num_bank_tables;
+
+// Ports used in the current bundle, per table and bank, and the rows
+// they read; lookups of a row already being read share its port
+uint8_t *bank_used;  // [table][bank]
+uint32_t *bank_rows; // [table][bank][port]
+
+// Current fetch bundle
+int bundle_open = 0;
+uint32_t block_start;    // address of its fetch block
+uint32_t next_fetch = 0; // where fetch continues after the last record
+int bundle_branches;
+
+uint64_t table_lookups[MAX_BP_TABLES];
+uint64_t table_conflicts[MAX_BP_TABLES];
+uint64_t num_bundles = 0;
+uint64_t num_bundled = 0;       // conditional branches
+uint64_t num_conflicting = 0;   // branches with at least one conflict
+uint64_t bank_stalls = 0;       // extra bundles
+uint64_t fallback_lost = 0;     // correct predictions replaced by wrong ones
+uint64_t fallback_gained = 0;   // wrong predictions replaced by correct ones
+
+//------------------------------------//
+//          Bank Functions            //
+//------------------------------------//
+
+void init_banks()
+{
+  num_bank_tables = declare_tables(bank_tables);
+  bank_used = (uint8_t *)calloc(num_bank_tables * numBanks, sizeof(uint8_t));
+  bank_rows = (uint32_t *)calloc(num_bank_tables * numBanks * bankPorts, sizeof(uint32_t));
+}
+
+// Open a bundle at the branch at PC 'pc'. Fetch reaches it block by
+// block from the fetch address, unless the trace jumped backwards.
+//
+void start_bundle(uint32_t pc)
+{
+  block_start = (pc >= next_fetch) ? next_fetch + (pc - next_fetch) / fetchBlock * fetchBlock : pc;
+  bundle_open = 1;
+  bundle_branches = 0;
+  num_bundles++;
+  memset(bank_used, 0, num_bank_tables * numBanks);
+}
+
+// Claim a port of the bank holding the entry a lookup reads
+//
+// Returns True if the bank had a free port or already read the row
+//
+int claim_port(const bp_lookup *lookup, int claim)
+{
+  int slot = lookup->table * numBanks + lookup->index % numBanks;
+  uint32_t *rows = &bank_rows[slot * bankPorts];
+  for (int p = 0; p < bank_used[slot]; p++)
+  {
+    if (rows[p] == lookup->index)
+      return 1;
+  }
+  if (bank_used[slot] == bankPorts)
+    return 0;
+  if (claim)
+    rows[bank_used[slot]++] = lookup->index;
+  return 1;
+}
+
+int bank_fetch(const br_record *r, const bp_context *ctx)
+{
+  int conditional = r->condition == 1;
+  if (!bundle_open || r->pc < block_start || r->pc - block_start >= (uint32_t)fetchBlock ||
+      (conditional && bundle_branches == bundleWidth))
+  {
+    start_bundle(r->pc);
+  }
+
+  int fallback = 0;
+  uint8_t direction = TAKEN;
+  if (conditional)
+  {
+    bp_lookup lookups[MAX_BP_LOOKUPS];
+    int n = context_lookups(r->pc, ctx, lookups);
+    int conflicts = 0;
+    for (int i = 0; i < n; i++)
+    {
+      table_lookups[lookups[i].table]++;
+      if (!claim_port(&lookups[i], 0))
+      {
+        table_conflicts[lookups[i].table]++;
+        conflicts++;
+      }
+    }
+    if (conflicts > 0)
+    {
+      num_conflicting++;
+      if (bankFallback == BANK_STALL)
+      {
+        // Predicted alone in the next cycle
+        bank_stalls++;
+        start_bundle(r->pc);
+      }
+      else
+      {
+        fallback = 1;
+      }
+    }
+    for (int i = 0; i < n; i++)
+    {
+      claim_port(&lookups[i], 1);
+    }
+    bundle_branches++;
+    num_bundled++;
+    direction = fallback ? TAKEN : ctx->prediction;
+  }
+
+  // Fetch continues at the target of a taken or predicted taken branch
+  // in the next cycle
+  if (r->outcome || direction == TAKEN)
+  {
+    next_fetch = r->target;
+    bundle_open = 0;
+  }
+  else
+  {
+    next_fetch = r->pc + 1;
+  }
+  return fallback;
+}
+
+void account_fallback(uint8_t prediction, uint8_t outcome)
+{
+  fallback_lost += (prediction == outcome && outcome != TAKEN);
+  fallback_gained += (prediction != outcome && outcome == TAKEN);
+}
+
+void print_bank_stats()
+{
+  printf("Banked tables:   %d banks x %d ports, %d branches per %d-byte bundle, %s fallback\n",
+         numBanks, bankPorts, bundleWidth, fetchBlock, bankFallbackName[bankFallback]);
+  printf("Bundles:         %10llu\n", (unsigned long long)num_bundles);
+  printf("Branches/bundle:    %7.3f\n", (double)num_bundled / (double)(num_bundles + (num_bundles == 0)));
+  printf("  %-18s  %12s  %12s  %7s\n", "Structure", "Lookups", "Conflicts", "Rate%");
+  for (int t = 0; t < num_bank_tables; t++)
+  {
+    if (table_lookups[t] == 0)
+      continue;
+    printf("  %-18s  %12llu  %12llu  %7.3f\n", bank_tables[t].name, (unsigned long long)table_lookups[t],
+           (unsigned long long)table_conflicts[t], 100.0 * table_conflicts[t] / table_lookups[t]);
+  }
+  printf("Conflicting:     %10llu branches\n", (unsigned long long)num_conflicting);
+  if (bankFallback == BANK_STALL)
+  {
+    printf("Stall cycles:    %10llu (%.3f%% of bundles)\n", (unsigned long long)bank_stalls,
+           100.0 * bank_stalls / (double)(num_bundles + (num_bundles == 0)));
+  }
+  else
+  {
+    printf("Fallback lost:   %10llu\n", (unsigned long long)fallback_lost);
+    printf("Fallback gained: %10llu\n", (unsigned long long)fallback_gained);
+  }
+}
+
+void cleanup_banks()
+{
+  free(bank_used);
+  free(bank_rows);
+}
@@ -0,0 +1,46 @@
+//========================================================//
+//  bank.h                                                //
+//  Header file for the banked table model                //
+//                                                        //
+//  Groups branches into fetch bundles predicted in the   //
+//  same cycle and counts conflicts in banked tables      //
+//========================================================//
+
+#ifndef BANK_H
+#define BANK_H
+
+#include <stdint.h>
+#include "predictor.h"
+
+// What a lookup does when its bank has no free port
+#define BANK_STATIC 0 // predict taken, as the static predictor
+#define BANK_STALL 1  // wait for the next cycle, ending the bundle
+extern const char *bankFallbackName[];
+
+extern int numBanks;     // banks per table (the model is disabled when 0)
+extern int bankPorts;    // read ports per bank
+extern int bundleWidth;  // most conditional branches predicted per cycle
+extern int fetchBlock;   // bytes fetched per cycle
+extern int bankFallback;
+
+// Initialize the model for the tables of the configured predictor
+//
+void init_banks();
+
+// Place the record in the current fetch bundle or start the next one,
+// and claim bank ports for the lookups of a conditional branch predicted
+// with 'ctx'
+//
+// Returns True if the prediction falls back to static taken
+//
+int bank_fetch(const br_record *r, const bp_context *ctx);
+
+// Account a scored branch whose prediction fell back, and print the
+// bundle and conflict statistics
+//
+void account_fallback(uint8_t prediction, uint8_t outcome);
+void print_bank_stats();
+
+void cleanup_banks();
+
+#endif
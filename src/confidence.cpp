@@ -0,0 +1,143 @@
+//========================================================//
+//  confidence.cpp                                        //
+//  Source file for branch confidence estimation          //
+//                                                        //
+//  JRS resetting counters and counter saturation, with   //
+//  PVP/PVN, sensitivity and specificity per threshold    //
+//========================================================//
+#include <stdio.h>
+#include <stdlib.h>
+#include "confidence.h"
+
+//------------------------------------//
+//     Confidence Configuration       //
+//------------------------------------//
+
+const char *confName[3] = {"None", "JRS", "Saturation"};
+
+int confType = CONF_NONE;
+int confBits = 12;       // Number of bits used for the JRS table index
+int confThreshold = -1;  // default: the highest level
+
+#define JRS_MAX 15 // 4-bit resetting counters
+
+//------------------------------------//
+//   Confidence Data Structures       //
+//------------------------------------//
+
+uint8_t *jrs_table; // (2^confBits) * 4 bits
+
+// Scored predictions by confidence level and correctness
+uint64_t conf_correct[JRS_MAX + 1];
+uint64_t conf_incorrect[JRS_MAX + 1];
+
+//------------------------------------//
+//     Confidence Functions           //
+//------------------------------------//
+
+void init_confidence()
+{
+  if (confType == CONF_JRS)
+  {
+    int jrs_entries = 1 << confBits;
+    jrs_table = (uint8_t *)malloc(jrs_entries * sizeof(uint8_t));
+    for (int i = 0; i < jrs_entries; i++)
+    {
+      jrs_table[i] = 0;
+    }
+  }
+  if (confThreshold < 0)
+  {
+    confThreshold = confidence_levels() - 1;
+  }
+}
+
+int confidence_levels()
+{
+  return (confType == CONF_JRS) ? JRS_MAX + 1 : 2;
+}
+
+uint32_t jrs_index(uint32_t pc, const bp_context *ctx)
+{
+  return (pc ^ (uint32_t)ctx->ghistory) & ((1 << confBits) - 1);
+}
+
+uint8_t estimate_confidence(uint32_t pc, const bp_context *ctx)
+{
+  switch (confType)
+  {
+  case CONF_JRS:
+    return jrs_table[jrs_index(pc, ctx)];
+  case CONF_SAT:
+    return (ctx->counter == SN || ctx->counter == ST) ? 1 : 0;
+  default:
+    return 0;
+  }
+}
+
+void train_confidence(uint32_t pc, const bp_context *ctx, uint8_t correct)
+{
+  if (confType == CONF_JRS)
+  {
+    uint8_t *entry = &jrs_table[jrs_index(pc, ctx)];
+    *entry = correct ? (*entry < JRS_MAX ? *entry + 1 : JRS_MAX) : 0;
+  }
+}
+
+void account_confidence(uint8_t level, uint8_t correct)
+{
+  if (correct)
+    conf_correct[level]++;
+  else
+    conf_incorrect[level]++;
+}
+
+// With HC the predictions at or above a threshold and LC the rest:
+//   Coverage = P(HC)
+//   PVP  = P(correct | HC),   Sens = P(HC | correct)
+//   PVN  = P(incorrect | LC), Spec = P(LC | incorrect)
+//
+void print_confidence_curves()
+{
+  int levels = confidence_levels();
+  uint64_t total_correct = 0, total_incorrect = 0;
+  for (int l = 0; l < levels; l++)
+  {
+    total_correct += conf_correct[l];
+    total_incorrect += conf_incorrect[l];
+  }
+
+  printf("Confidence (%s):\n", confName[confType]);
+  printf("  %9s  %8s  %8s  %8s  %8s  %8s\n", "Threshold", "Coverage", "PVP", "Sens", "PVN", "Spec");
+  for (int t = 1; t < levels; t++)
+  {
+    // Predictions below the threshold are low confidence
+    uint64_t lc_correct = 0, lc_incorrect = 0;
+    for (int l = 0; l < t; l++)
+    {
+      lc_correct += conf_correct[l];
+      lc_incorrect += conf_incorrect[l];
+    }
+    uint64_t hc_correct = total_correct - lc_correct;
+    uint64_t hc_incorrect = total_incorrect - lc_incorrect;
+    double hc = (double)(hc_correct + hc_incorrect);
+    double lc = (double)(lc_correct + lc_incorrect);
+    char label[16];
+    snprintf(label, sizeof(label), "%s%d", t == confThreshold ? "*" : "", t);
+
+    printf("  %9s  %8.4f  %8.4f  %8.4f  %8.4f  %8.4f\n", label,
+           hc / (hc + lc),
+           hc > 0 ? hc_correct / hc : 0.0,
+           total_correct > 0 ? (double)hc_correct / total_correct : 0.0,
+           lc > 0 ? lc_incorrect / lc : 0.0,
+           total_incorrect > 0 ? (double)lc_incorrect / total_incorrect : 0.0);
+  }
+}
+
+void cleanup_confidence()
+{
+  if (confType == CONF_JRS)
+  {
+    free(jrs_table);
+  }
+}
@@ -0,0 +1,47 @@
+//========================================================//
+//  confidence.h                                          //
+//  Header file for branch confidence estimation          //
+//                                                        //
+//  Estimators that grade every prediction of any         //
+//  predictor as high or low confidence                   //
+//========================================================//
+
+#ifndef CONFIDENCE_H
+#define CONFIDENCE_H
+
+#include <stdint.h>
+#include "predictor.h"
+
+// The Different Confidence Estimators
+#define CONF_NONE 0
+#define CONF_JRS 1 // resetting counters indexed by PC xor global history
+#define CONF_SAT 2 // the providing 2-bit counter is saturated
+extern const char *confName[];
+
+extern int confType;
+extern int confBits;      // log2 of the JRS table entries
+extern int confThreshold; // lowest level graded high confidence
+
+// Initialize the estimator
+//
+void init_confidence();
+
+// Confidence level of the prediction made with 'ctx' for the branch at
+// PC 'pc', from 0 up to confidence_levels() - 1
+//
+uint8_t estimate_confidence(uint32_t pc, const bp_context *ctx);
+int confidence_levels();
+
+// Train the estimator once the branch has resolved
+//
+void train_confidence(uint32_t pc, const bp_context *ctx, uint8_t correct);
+
+// Account a scored prediction, and print the PVP/PVN, sensitivity and
+// specificity of every threshold over the accounted predictions
+//
+void account_confidence(uint8_t level, uint8_t correct);
+void print_confidence_curves();
+
+void cleanup_confidence();
+
+#endif
@@ -0,0 +1,123 @@
+//========================================================//
+//  counter_map.cpp                                       //
+//  Source file for the unbounded counter map             //
+//                                                        //
+//  Arena-backed open addressing with linear probing and  //
+//  Fibonacci hashing                                     //
+//========================================================//
+#include <stdlib.h>
+#include "counter_map.h"
+
+#define ARENA_CHUNK_BITS 16
+
+uint32_t counter_hash(uint64_t key)
+{
+  return (uint32_t)((key * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+counter_entry *map_entry(const counter_map *map, uint32_t n)
+{
+  return &map->chunks[n >> ARENA_CHUNK_BITS][n & ((1u << ARENA_CHUNK_BITS) - 1)];
+}
+
+uint32_t alloc_entry(counter_map *map)
+{
+  if ((map->used >> ARENA_CHUNK_BITS) == map->num_chunks)
+  {
+    map->num_chunks++;
+    map->chunks = (counter_entry **)realloc(map->chunks, map->num_chunks * sizeof(counter_entry *));
+    map->chunks[map->num_chunks - 1] = (counter_entry *)malloc(sizeof(counter_entry) << ARENA_CHUNK_BITS);
+  }
+  return map->used++;
+}
+
+// The fingerprint skips most mismatching entries without reading the
+// arena
+//
+counter_slot *find_slot(counter_map *map, uint64_t key, uint32_t fingerprint)
+{
+  uint32_t mask = (1u << map->bits) - 1;
+  uint32_t slot = fingerprint >> (32 - map->bits);
+  while (map->slots[slot].entry != 0)
+  {
+    if (map->slots[slot].fingerprint == fingerprint &&
+        map_entry(map, map->slots[slot].entry - 1)->key == key)
+      break;
+    slot = (slot + 1) & mask;
+  }
+  return &map->slots[slot];
+}
+
+// Double the slots once half of them are used to keep probe sequences
+// short. Slot positions follow from the fingerprints alone, so the
+// arena is not touched.
+//
+void grow_counter_map(counter_map *map)
+{
+  counter_slot *old_slots = map->slots;
+  uint32_t old_entries = 1u << map->bits;
+
+  map->bits++;
+  map->slots = (counter_slot *)calloc((size_t)1 << map->bits, sizeof(counter_slot));
+  uint32_t mask = (1u << map->bits) - 1;
+  for (uint32_t i = 0; i < old_entries; i++)
+  {
+    if (old_slots[i].entry != 0)
+    {
+      uint32_t slot = old_slots[i].fingerprint >> (32 - map->bits);
+      while (map->slots[slot].entry != 0)
+      {
+        slot = (slot + 1) & mask;
+      }
+      map->slots[slot] = old_slots[i];
+    }
+  }
+  free(old_slots);
+}
+
+void init_counter_map(counter_map *map)
+{
+  map->chunks = NULL;
+  map->num_chunks = 0;
+  map->used = 0;
+  map->bits = 16;
+  map->slots = (counter_slot *)calloc((size_t)1 << map->bits, sizeof(counter_slot));
+}
+
+uint8_t *find_counter(counter_map *map, uint64_t key, uint8_t init, int create)
+{
+  uint32_t fingerprint = counter_hash(key);
+  counter_slot *slot = find_slot(map, key, fingerprint);
+  if (slot->entry == 0)
+  {
+    if (!create)
+      return NULL;
+    if (2 * (map->used + 1) > (1u << map->bits))
+    {
+      grow_counter_map(map);
+      slot = find_slot(map, key, fingerprint);
+    }
+    uint32_t n = alloc_entry(map);
+    map_entry(map, n)->key = key;
+    map_entry(map, n)->counter = init;
+    slot->fingerprint = fingerprint;
+    slot->entry = n + 1;
+  }
+  return &map_entry(map, slot->entry - 1)->counter;
+}
+
+size_t counter_map_bytes(const counter_map *map)
+{
+  return ((size_t)map->num_chunks * sizeof(counter_entry) << ARENA_CHUNK_BITS) +
+         ((size_t)sizeof(counter_slot) << map->bits);
+}
+
+void free_counter_map(counter_map *map)
+{
+  for (uint32_t i = 0; i < map->num_chunks; i++)
+  {
+    free(map->chunks[i]);
+  }
+  free(map->chunks);
+  free(map->slots);
+}
@@ -0,0 +1,53 @@
+//========================================================//
+//  counter_map.h                                         //
+//  Header file for the unbounded counter map             //
+//                                                        //
+//  Maps 64-bit keys to saturating counters that never    //
+//  alias, for the oracle and the aliasing analyzer       //
+//========================================================//
+
+#ifndef COUNTER_MAP_H
+#define COUNTER_MAP_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct
+{
+  uint64_t key;
+  uint8_t counter;
+} counter_entry;
+
+typedef struct
+{
+  uint32_t fingerprint; // upper half of the key hash
+  uint32_t entry;       // entry number + 1, 0 when the slot is empty
+} counter_slot;
+
+// Entries are bump-allocated from fixed-size chunks of an arena and
+// never move; the open-addressing table only holds their numbers
+typedef struct
+{
+  counter_entry **chunks;
+  uint32_t num_chunks;
+  uint32_t used;       // number of entries
+  counter_slot *slots;
+  int bits;            // log2 of the number of slots
+} counter_map;
+
+void init_counter_map(counter_map *map);
+
+// Find the counter of 'key', creating it in state 'init' when 'create'
+// is set
+//
+// Returns NULL if the key has no counter and none was created
+//
+uint8_t *find_counter(counter_map *map, uint64_t key, uint8_t init, int create);
+
+// Bytes held by the arena and the slots
+//
+size_t counter_map_bytes(const counter_map *map);
+
+void free_counter_map(counter_map *map);
+
+#endif
@@ -0,0 +1,150 @@
+//========================================================//
+//  flush.cpp                                             //
+//  Source file for the predictor flush model             //
+//                                                        //
+//  Flushes reset structures in bulk; the branches right  //
+//  after them show how fast the predictor warms up again //
+//========================================================//
+#include <stdio.h>
+#include <string.h>
+#include "flush.h"
+
+//------------------------------------//
+//       Flush Configuration          //
+//------------------------------------//
+
+const char *flushName[4] = {"history", "tables", "chooser", "caches"};
+
+int flushStructures = 0;
+uint64_t flushInterval = 0;
+int flushAtEvents = 0;
+uint64_t flushWindow = 10000;
+
+//------------------------------------//
+//       Flush Data Structures        //
+//------------------------------------//
+
+uint64_t fetched_branches;  // conditional branches fetched so far
+uint64_t since_flush;       // conditional branches resolved since the last flush
+int flushed = 0;            // no flush yet, so no window is open
+
+// Measured region
+uint64_t num_flushes = 0;
+uint64_t window_branches = 0;
+uint64_t window_incorrect = 0;
+uint64_t other_branches = 0;
+uint64_t other_incorrect = 0;
+
+//------------------------------------//
+//         Flush Functions            //
+//------------------------------------//
+
+int parse_flush_structures(const char *list)
+{
+  if (!strcmp(list, "all"))
+  {
+    flushStructures = FLUSH_ALL;
+    return 1;
+  }
+  flushStructures = 0;
+  while (*list != '\0')
+  {
+    size_t len = strcspn(list, ",");
+    int found = 0;
+    for (int i = 0; i < 4; i++)
+    {
+      if (strlen(flushName[i]) == len && !strncmp(list, flushName[i], len))
+      {
+        flushStructures |= 1 << i;
+        found = 1;
+      }
+    }
+    if (!found)
+      return 0;
+    list += len + (list[len] == ',');
+  }
+  return flushStructures != 0;
+}
+
+void init_flush(uint64_t branches)
+{
+  fetched_branches = branches;
+  since_flush = 0;
+  flushed = 0;
+}
+
+int flush_due(const br_record *r)
+{
+  int due = flushAtEvents && r->event;
+  if (r->condition == 1)
+  {
+    fetched_branches++;
+    due |= flushInterval > 0 && fetched_branches > 1 && (fetched_branches - 1) % flushInterval == 0;
+  }
+  return due;
+}
+
+void flush_now(int measure)
+{
+  flush_predictor(flushStructures);
+  since_flush = 0;
+  flushed = 1;
+  num_flushes += measure;
+}
+
+void account_flush_branch(int correct, int measure)
+{
+  int in_window = flushed && since_flush++ < flushWindow;
+  if (!measure)
+    return;
+  if (in_window)
+  {
+    window_branches++;
+    window_incorrect += !correct;
+  }
+  else
+  {
+    other_branches++;
+    other_incorrect += !correct;
+  }
+}
+
+void print_flush_stats(const uint64_t *unflushed)
+{
+  char names[64] = "";
+  for (int i = 0; i < 4; i++)
+  {
+    if (flushStructures & (1 << i))
+    {
+      strcat(names, names[0] ? "," : "");
+      strcat(names, flushName[i]);
+    }
+  }
+  printf("Flushing:        %s", names);
+  if (flushInterval > 0)
+    printf(" every %llu branches", (unsigned long long)flushInterval);
+  if (flushAtEvents)
+    printf("%s at trace events", (flushInterval > 0) ? " and" : "");
+  printf("\n");
+  printf("Flushes:         %10llu\n", (unsigned long long)num_flushes);
+  printf("After flushes:   %10llu branches, %llu incorrect (%llu-branch windows)\n",
+         (unsigned long long)window_branches, (unsigned long long)window_incorrect,
+         (unsigned long long)flushWindow);
+  printf("Elsewhere:       %10llu branches, %llu incorrect\n", (unsigned long long)other_branches,
+         (unsigned long long)other_incorrect);
+  if (unflushed == NULL)
+  {
+    // Without the unflushed run the windows can only be compared with the
+    // rest of the trace, whose rate differs by phase as well as by warmup
+    printf("Window rate:     %10.3f after flushes, %.3f elsewhere (not a warmup cost)\n",
+           1000.0 * window_incorrect / (double)(window_branches + (window_branches == 0)),
+           1000.0 * other_incorrect / (double)(other_branches + (other_branches == 0)));
+    printf("Warmup cost:              - (needs the unflushed run of a trace file)\n");
+    return;
+  }
+  uint64_t branches = window_branches + other_branches;
+  double extra = (double)(window_incorrect + other_incorrect) - (double)*unflushed;
+  printf("Unflushed:       %10llu incorrect\n", (unsigned long long)*unflushed);
+  printf("Warmup cost:     %10.0f mispredictions (%.1f per flush, %.3f per 1000 branches)\n", extra,
+         extra / (double)(num_flushes + (num_flushes == 0)), 1000 * extra / (double)(branches + (branches == 0)));
+}
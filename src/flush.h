@@ -0,0 +1,53 @@
+//========================================================//
+//  flush.h                                               //
+//  Header file for the predictor flush model             //
+//                                                        //
+//  Flushes selected predictor structures at intervals or //
+//  trace events and estimates the warmup they cost       //
+//========================================================//
+
+#ifndef FLUSH_H
+#define FLUSH_H
+
+#include <stdint.h>
+#include "predictor.h"
+
+extern int flushStructures;    // FLUSH_* mask (the model is disabled when 0)
+extern uint64_t flushInterval; // conditional branches between flushes, 0 for none
+extern int flushAtEvents;      // flush at the event lines of the trace
+extern uint64_t flushWindow;   // conditional branches after a flush counted as its warmup
+
+// Parse a comma separated list of structure names, or "all", into
+// flushStructures
+//
+// Returns True if Successful
+//
+int parse_flush_structures(const char *list);
+
+// Start the model with 'branches' conditional branches already fetched
+//
+void init_flush(uint64_t branches);
+
+// Count a fetched record
+//
+// Returns True if the predictor is flushed before the record
+//
+int flush_due(const br_record *r);
+
+// Flush the predictor, once the older branches have resolved
+//
+void flush_now(int measure);
+
+// Account a resolved conditional branch
+//
+void account_flush_branch(int correct, int measure);
+
+// Print the flushes and the mispredictions they add over 'unflushed',
+// those of the same run without flushes. When it is NULL (a trace read
+// from stdin is not simulated twice) only the misprediction rates in
+// and outside the windows after the flushes are printed, since their
+// difference includes phase behavior and is no measure of the cost.
+//
+void print_flush_stats(const uint64_t *unflushed);
+
+#endif
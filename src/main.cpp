@@ -7,78 +7,1856 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #include "predictor.h"
+#include "profiler.h"
+#include "trace.h"
+#include "sweep.h"
+#include "confidence.h"
+#include "oracle.h"
+#include "alias.h"
+#include "access.h"
+#include "bank.h"
+#include "override.h"
+#include "flush.h"
+#include "timing.h"
+#include "results.h"
 
 FILE *stream;
+const char *trace_path = NULL; // NULL when reading stdin
 char *buf = NULL;
 size_t len = 0;
 
+// Trace summary from the sidecar or the embedded "!!!" header lines,
+// and whether records carry their per-branch instruction deltas
+trace_info info = {0, 0, 0, 0, 0};
+const char *sidecar_path = NULL;
+uint64_t instructions_override = 0;
+int has_inst_deltas = 0;
+
+// First-order cycle model: 'fetch_width' instructions issue per cycle
+// and every misprediction stalls fetch for 'mispredict_penalty' cycles.
+// Given a 'pipeline_depth' and per-branch instruction deltas, a
+// misprediction instead costs the front-end refill plus the cycles to
+// fetch the instructions since the last redirect, at most the penalty,
+// so mispredictions close together overlap.
+int mispredict_penalty = 20;
+int pipeline_depth = 0;
+int fetch_width = 4;
+uint64_t insts_since_redirect = 0;
+
+// Predictor snapshot files (NULL when unused)
+const char *load_state_path = NULL;
+const char *save_state_path = NULL;
+
+// Largest predictor storage in bits that may be simulated (0 for no
+// limit)
+uint64_t budget_bits = 0;
+
+// Print the canonical predictor spec and its storage breakdown, which
+// --budget also prints
+int storage_report = 0;
+
+// Print the estimated access time and area of the structures; a cycle
+// time (cycleTime) refuses predictors whose slowest structure misses it
+int timing_report = 0;
+
+// Results database (NULL when unused). Runs already recorded for the
+// same trace content, build and configuration are not simulated again
+// unless 'force_simulation' is set.
+const char *results_db_path = NULL;
+int force_simulation = 0;
+uint64_t trace_hash;
+uint64_t build_hash;
+#define NUM_RESULT_VALUES 16
+
+// Number of leading trace records used only to train the predictor
+uint64_t warmup_records = 0;
+
+// Mispredict statistics for one region of the trace
+typedef struct
+{
+  uint64_t num_branches;
+  uint64_t mispredictions;
+  uint64_t instructions; // from per-branch deltas, 0 when unknown
+  uint64_t stall_cycles; // fetch cycles lost to mispredictions
+} region_stats;
+
+// A branch record between its prediction and its in-order update
+typedef struct
+{
+  br_record rec;
+  uint32_t prediction;
+  bp_context ctx;
+  uint8_t confidence; // level from the confidence estimator
+  uint8_t fallback;   // a bank conflict replaced the prediction
+  uint8_t fast;       // prediction of the overridden fast predictor
+  uint32_t fast_index; // and the entry it read
+} inflight_branch;
+
+// Number of younger records that are predicted before a branch resolves
+// and updates the predictor (0 updates right after the prediction)
+uint32_t resolve_delay = 0;
+inflight_branch *inflight; // ring buffer of resolve_delay + 1 branches
+uint32_t window;
+uint64_t head = 0;          // oldest in-flight branch
+uint64_t tail = 0;          // next branch to be predicted
+uint64_t num_squashed = 0;  // predictions redone after a history repair
+
+// Records simulated per predict_train_batch call when branches update the
+// predictor immediately
+#define BATCH_RECORDS 4096
+
+region_stats warmup = {0, 0, 0, 0};
+region_stats measured = {0, 0, 0, 0};
+region_stats interval = {0, 0, 0, 0};
+uint64_t num_intervals = 0;
+uint64_t num_records = 0;
+
+// Baseline predictor the CPI is compared with (NULL when unused). It
+// runs first in a forked process, which hands its region and interval
+// statistics back through 'baseline_file'.
+const char *baseline_spec = NULL;
+int baseline_run = 0; // set in the forked process
+FILE *baseline_file = NULL;
+region_stats baseline_warmup, baseline_measured;
+region_stats *baseline_intervals = NULL;
+uint64_t num_baseline_intervals = 0;
+
+// A flushed run from a trace file also runs without the flushes, the
+// same way, to measure their cost
+region_stats unflushed_measured;
+int has_unflushed = 0;
+
+// Chunk-parallel simulation: the trace is split into 'parallel_chunks'
+// contiguous chunks simulated by forked workers with private predictors,
+// each warmed on the 'parallel_warmup' records before its chunk
+// (disabled when 0)
+int parallel_chunks = 0;
+uint64_t parallel_warmup = 1000000;
+int parallel_check = 0; // also run serially and report the error
+
+// Statistics a parallel worker hands back through shared memory
+typedef struct
+{
+  region_stats warmup;
+  region_stats measured;
+  double seconds;
+  int done;
+} chunk_result;
+
+// Multi-process sweep: every line of 'sweep_path' is a job made of
+// predictor options applied on top of the command line. Jobs run in
+// forked workers sharing the decoded trace read-only.
+const char *sweep_path = NULL;
+int sweep_workers = 0;      // default: one per online CPU
+double sweep_timeout = 0;   // seconds per job attempt, 0 for none
+int sweep_retries = 1;
+char **sweep_jobs;
+int num_sweep_jobs = 0;
+const br_record *sweep_records;
+size_t num_sweep_records;
+
+// What a sweep worker reports for its job
+typedef struct
+{
+  region_stats warmup;
+  region_stats measured;
+  uint64_t squashed;
+  uint64_t budget;  // predictor storage in bits
+  double access_ps; // access time of the slowest structure
+  int over_budget;  // skipped without simulating
+  int over_timing;  // skipped without simulating
+  int cached;       // taken from the results database
+} sweep_result;
+
+// Successive halving: every sweep job first runs on a short prefix of
+// the trace, and after each round only the best 1/halving_rate of them
+// continue, from their saved predictor state, on a prefix halving_rate
+// times longer. The last round runs at least 'halving_keep' survivors
+// to the end of the trace. No round is shorter than 'halving_min'
+// records, since rankings on short prefixes are mostly cold-start noise.
+// (disabled when 0)
+int halving_rate = 0;
+int halving_keep = 1;
+uint64_t halving_min = 1000000;
+char halving_dir[] = "/tmp/predictor-halving-XXXXXX"; // predictor snapshots
+int *halving_jobs;                 // sweep job of every worker in a round
+sweep_result *halving_progress;    // statistics of every job so far
+size_t halving_begin, halving_end; // records of the current round
+int halving_last;                  // the current round is the last one
+
+// Interval statistics are written every 'interval_branches' conditional
+// branches as CSV lines to 'interval_stream' (disabled when 0)
+uint64_t interval_branches = 0;
+const char *interval_path = NULL;
+FILE *interval_stream = NULL;
+
+// Number of worst static branches reported by the per-branch profiler
+// (profiling is disabled when 0)
+int top_branches = 0;
+
+// Per-structure access energies replacing the SRAM model (NULL when
+// unused); counting needs the build with -DBP_ACCESS_STATS
+const char *energy_path = NULL;
+
+// Shadow the predictor with an interference-free oracle
+int oracle_enabled = 0;
+
+// Confidence bits of the conditional branches, packed LSB first into
+// 64-bit words with 1 for high confidence (disabled when NULL)
+const char *conf_out_path = NULL;
+FILE *conf_stream = NULL;
+uint64_t conf_word = 0;
+int conf_word_bits = 0;
+
 // Print out the Usage information to stderr
 //
-void usage()
+void usage()
+{
+  fprintf(stderr, "Usage: predictor <options> [<trace>]\n");
+  fprintf(stderr, "       bunzip2 -kc trace.bz2 | predictor <options>\n");
+  fprintf(stderr, " Options:\n");
+  fprintf(stderr, " --help                   Print this message\n");
+  fprintf(stderr, " --verbose                Print predictions on stdout\n");
+  fprintf(stderr, " --warmup=<n>             Train on the first n records without scoring them\n");
+  fprintf(stderr, " --delay=<n>              Resolve each branch n records after its prediction\n");
+  fprintf(stderr, " --spec-history           Update histories at prediction, repair on mispredict\n");
+  fprintf(stderr, " --parallel=<k>           Simulate k trace chunks in parallel (approximate)\n");
+  fprintf(stderr, " --parallel-warmup=<n>    Records replayed before each chunk (default 1000000)\n");
+  fprintf(stderr, " --parallel-check         Also simulate serially and report the error\n");
+  fprintf(stderr, " --sweep=<file>           Run each line of options as a job in its own process\n");
+  fprintf(stderr, " --sweep-workers=<n>      Concurrent sweep workers (default: CPU count)\n");
+  fprintf(stderr, " --job-timeout=<seconds>  Kill sweep jobs that run longer\n");
+  fprintf(stderr, " --job-retries=<n>        Retries for failed sweep jobs (default 1)\n");
+  fprintf(stderr, " --halving=<eta>          Keep the best 1/eta sweep jobs on eta times longer prefixes\n");
+  fprintf(stderr, " --halving-keep=<n>       Sweep jobs run to the end of the trace (default 1)\n");
+  fprintf(stderr, " --halving-min=<n>        Records of the first halving round (default 1000000)\n");
+  fprintf(stderr, " --interval=<n>           Write statistics every n conditional branches\n");
+  fprintf(stderr, " --interval-out=<file>    CSV file for interval statistics (default stderr)\n");
+  fprintf(stderr, " --sidecar=<file>         Trace summary file (default <trace>.txt)\n");
+  fprintf(stderr, " --instructions=<n>       Instruction count of the trace for MPKI\n");
+  fprintf(stderr, " --penalty=<cycles>       Misprediction penalty for the CPI estimate\n");
+  fprintf(stderr, " --pipeline-depth=<n>     Front-end refill cycles; overlaps close mispredictions\n");
+  fprintf(stderr, " --fetch-width=<n>        Instructions fetched per cycle (default 4)\n");
+  fprintf(stderr, " --baseline=<spec>        Report the speedup over this predictor, e.g. gshare:hist=12\n");
+  fprintf(stderr, " --top=<k>                Report the k most mispredicted branches\n");
+  fprintf(stderr, " --budget=<bits>          Refuse predictors with more storage (K/M suffixes)\n");
+  fprintf(stderr, " --report                 Print the predictor spec and its storage\n");
+  fprintf(stderr, " --timing                 Print the access time and area of every structure\n");
+  fprintf(stderr, " --tech=<nm>              Technology node of the timing model (default 22)\n");
+  fprintf(stderr, " --cycle-time=<ps>        Refuse predictors with slower structures\n");
+  fprintf(stderr, " --oracle                 Report the gap to an interference-free predictor\n");
+  fprintf(stderr, " --confidence=<jrs|sat>   Grade predictions with a confidence estimator\n");
+  fprintf(stderr, " --conf-bits=<n>          Index bits of the JRS table (default 12)\n");
+  fprintf(stderr, " --conf-threshold=<n>     Lowest high-confidence level (default: highest)\n");
+  fprintf(stderr, " --conf-out=<file>        Write one confidence bit per conditional branch\n");
+  fprintf(stderr, " --banks=<n>              Predict fetch bundles from tables of n banks\n");
+  fprintf(stderr, " --bank-ports=<n>         Read ports per bank (default 1)\n");
+  fprintf(stderr, " --bundle=<n>             Conditional branches per fetch bundle (default 4)\n");
+  fprintf(stderr, " --fetch-block=<bytes>    Bytes fetched per cycle (default 32)\n");
+  fprintf(stderr, " --bank-fallback=<static|stall>\n"
+                  "                          Conflicting lookups predict taken or wait a cycle\n");
+  fprintf(stderr, " --override=<bimodal|gshare>:<bits>\n"
+                  "                          Let the predictor override a single-cycle one\n");
+  fprintf(stderr, " --override-latency=<n>   Cycles until the overriding prediction (default 2)\n");
+  fprintf(stderr, " --flush=<all|history,tables,chooser,caches>\n"
+                  "                          Flush these predictor structures at intervals or events\n");
+  fprintf(stderr, " --flush-every=<n>        Flush every n conditional branches\n");
+  fprintf(stderr, " --flush-at-events        Flush at the \"!!!\" event lines of the trace\n");
+  fprintf(stderr, " --flush-window=<n>       Branches after a flush counted as warmup (default 10000)\n");
+  fprintf(stderr, " --energy=<file>          Per-access energies of structures (make energy)\n");
+  fprintf(stderr, " --results-db=<file>      Record results, and reuse them for repeated runs\n");
+  fprintf(stderr, " --force                  Simulate even if the results database has the run\n");
+  fprintf(stderr, " --load-state=<file>      Restore a predictor snapshot before the run\n");
+  fprintf(stderr, " --save-state=<file>      Write a predictor snapshot after the run\n");
+  fprintf(stderr, " --<type>[:<key>=<bits>,...]\n");
+  fprintf(stderr, "                          Branch prediction scheme and table sizes:\n");
+  fprintf(stderr, "    static\n"
+                  "    gshare:hist=<n>\n"
+                  "    tournament:choice=<n>,global=<n>,local=<n>,pc=<n>\n"
+                  "    custom:cache=<n>,global=<n>,local=<n>,pc=<n>\n"
+                  "    hybrid:<bimodal|global|gshare|local>=<n>,...,choose=<tables|vote|perceptron>,\n"
+                  "           index=<pc|hist|pcxhist>,choice=<n>,pc=<n>\n");
+}
+
+// Process an option and update the predictor
+// configuration variables accordingly
+//
+// Returns True if Successful
+//
+int handle_option(char *arg)
+{
+  bp_config cfg;
+
+  if (!strcmp(arg, "--verbose"))
+  {
+    verbose = 1;
+  }
+  else if (!strncmp(arg, "--warmup=", 9))
+  {
+    warmup_records = strtoull(arg + 9, NULL, 10);
+  }
+  else if (!strncmp(arg, "--delay=", 8))
+  {
+    resolve_delay = strtoul(arg + 8, NULL, 10);
+  }
+  else if (!strcmp(arg, "--spec-history"))
+  {
+    spec_history = 1;
+  }
+  else if (!strncmp(arg, "--parallel=", 11))
+  {
+    parallel_chunks = atoi(arg + 11);
+  }
+  else if (!strncmp(arg, "--parallel-warmup=", 18))
+  {
+    parallel_warmup = strtoull(arg + 18, NULL, 10);
+  }
+  else if (!strcmp(arg, "--parallel-check"))
+  {
+    parallel_check = 1;
+  }
+  else if (!strncmp(arg, "--sweep=", 8))
+  {
+    sweep_path = arg + 8;
+  }
+  else if (!strncmp(arg, "--sweep-workers=", 16))
+  {
+    sweep_workers = atoi(arg + 16);
+  }
+  else if (!strncmp(arg, "--job-timeout=", 14))
+  {
+    sweep_timeout = atof(arg + 14);
+  }
+  else if (!strncmp(arg, "--job-retries=", 14))
+  {
+    sweep_retries = atoi(arg + 14);
+  }
+  else if (!strncmp(arg, "--halving=", 10))
+  {
+    halving_rate = atoi(arg + 10);
+  }
+  else if (!strncmp(arg, "--halving-keep=", 15))
+  {
+    halving_keep = atoi(arg + 15);
+  }
+  else if (!strncmp(arg, "--halving-min=", 14))
+  {
+    halving_min = strtoull(arg + 14, NULL, 10);
+  }
+  else if (!strncmp(arg, "--interval=", 11))
+  {
+    interval_branches = strtoull(arg + 11, NULL, 10);
+  }
+  else if (!strncmp(arg, "--interval-out=", 15))
+  {
+    interval_path = arg + 15;
+  }
+  else if (!strncmp(arg, "--sidecar=", 10))
+  {
+    sidecar_path = arg + 10;
+  }
+  else if (!strncmp(arg, "--instructions=", 15))
+  {
+    instructions_override = strtoull(arg + 15, NULL, 10);
+  }
+  else if (!strncmp(arg, "--penalty=", 10))
+  {
+    mispredict_penalty = atoi(arg + 10);
+  }
+  else if (!strncmp(arg, "--pipeline-depth=", 17))
+  {
+    pipeline_depth = atoi(arg + 17);
+  }
+  else if (!strncmp(arg, "--fetch-width=", 14))
+  {
+    fetch_width = atoi(arg + 14);
+  }
+  else if (!strncmp(arg, "--baseline=", 11))
+  {
+    baseline_spec = arg + 11;
+  }
+  else if (!strncmp(arg, "--top=", 6))
+  {
+    top_branches = atoi(arg + 6);
+  }
+  else if (!strncmp(arg, "--budget=", 9))
+  {
+    char *unit;
+    budget_bits = strtoull(arg + 9, &unit, 10);
+    if (*unit == 'K' || *unit == 'k')
+      budget_bits <<= 10;
+    else if (*unit == 'M' || *unit == 'm')
+      budget_bits <<= 20;
+  }
+  else if (!strcmp(arg, "--report"))
+  {
+    storage_report = 1;
+  }
+  else if (!strcmp(arg, "--timing"))
+  {
+    timing_report = 1;
+  }
+  else if (!strncmp(arg, "--tech=", 7))
+  {
+    techNode = atoi(arg + 7);
+  }
+  else if (!strncmp(arg, "--cycle-time=", 13))
+  {
+    cycleTime = atof(arg + 13);
+  }
+  else if (!strcmp(arg, "--oracle"))
+  {
+    oracle_enabled = 1;
+  }
+  else if (!strcmp(arg, "--confidence=jrs"))
+  {
+    confType = CONF_JRS;
+  }
+  else if (!strcmp(arg, "--confidence=sat"))
+  {
+    confType = CONF_SAT;
+  }
+  else if (!strncmp(arg, "--conf-bits=", 12))
+  {
+    confBits = atoi(arg + 12);
+  }
+  else if (!strncmp(arg, "--conf-threshold=", 17))
+  {
+    confThreshold = atoi(arg + 17);
+  }
+  else if (!strncmp(arg, "--banks=", 8))
+  {
+    numBanks = atoi(arg + 8);
+  }
+  else if (!strncmp(arg, "--bank-ports=", 13))
+  {
+    bankPorts = atoi(arg + 13);
+  }
+  else if (!strncmp(arg, "--bundle=", 9))
+  {
+    bundleWidth = atoi(arg + 9);
+  }
+  else if (!strncmp(arg, "--fetch-block=", 14))
+  {
+    fetchBlock = atoi(arg + 14);
+  }
+  else if (!strcmp(arg, "--bank-fallback=static"))
+  {
+    bankFallback = BANK_STATIC;
+  }
+  else if (!strcmp(arg, "--bank-fallback=stall"))
+  {
+    bankFallback = BANK_STALL;
+  }
+  else if (!strncmp(arg, "--override=bimodal:", 19))
+  {
+    overrideType = OVERRIDE_BIMODAL;
+    overrideBits = atoi(arg + 19);
+  }
+  else if (!strncmp(arg, "--override=gshare:", 18))
+  {
+    overrideType = OVERRIDE_GSHARE;
+    overrideBits = atoi(arg + 18);
+  }
+  else if (!strncmp(arg, "--override-latency=", 19))
+  {
+    overrideLatency = atoi(arg + 19);
+  }
+  else if (!strncmp(arg, "--flush=", 8))
+  {
+    return parse_flush_structures(arg + 8);
+  }
+  else if (!strncmp(arg, "--flush-every=", 14))
+  {
+    flushInterval = strtoull(arg + 14, NULL, 10);
+  }
+  else if (!strcmp(arg, "--flush-at-events"))
+  {
+    flushAtEvents = 1;
+  }
+  else if (!strncmp(arg, "--flush-window=", 15))
+  {
+    flushWindow = strtoull(arg + 15, NULL, 10);
+  }
+  else if (!strncmp(arg, "--energy=", 9))
+  {
+    energy_path = arg + 9;
+  }
+  else if (!strncmp(arg, "--conf-out=", 11))
+  {
+    conf_out_path = arg + 11;
+  }
+  else if (!strncmp(arg, "--results-db=", 13))
+  {
+    results_db_path = arg + 13;
+  }
+  else if (!strcmp(arg, "--force"))
+  {
+    force_simulation = 1;
+  }
+  else if (!strncmp(arg, "--load-state=", 13))
+  {
+    load_state_path = arg + 13;
+  }
+  else if (!strncmp(arg, "--save-state=", 13))
+  {
+    save_state_path = arg + 13;
+  }
+  else if (!strncmp(arg, "--", 2) && parse_predictor_spec(arg + 2, &cfg))
+  {
+    set_config(&cfg);
+  }
+  else
+  {
+    return 0;
+  }
+
+  return 1;
+}
+
+// Reads a line from the input stream and extracts the
+// PC and Outcome of a branch, and the number of instructions
+// since the previous record when the trace provides it
+//
+// Returns True if Successful
+//
+int read_branch(br_record *r)
+{
+  uint32_t pc, target, outcome, condition, call, ret, direct, insts;
+
+  r->event = 0;
+  do
+  {
+    if (getline(&buf, &len, stream) == -1)
+    {
+      return 0;
+    }
+    // Embedded summary lines take the place of a sidecar
+    r->event |= is_event_line(buf);
+  } while (parse_info_line(buf, &info));
+
+  insts = 0;
+  if (sscanf(buf, "0x%x\t0x%x\t%d\t%d\t%d\t%d\t%d\t%d\n", &pc, &target, &outcome, &condition, &call, &ret, &direct, &insts) == 8)
+  {
+    has_inst_deltas = 1;
+  }
+
+  r->pc = pc;
+  r->target = target;
+  r->insts = insts;
+  r->outcome = outcome;
+  r->condition = condition;
+  r->call = call;
+  r->ret = ret;
+  r->direct = direct;
+  return 1;
+}
+
+// Read up to 'n' records into 'records'
+//
+// Returns the number of records read
+//
+size_t read_batch(br_record *records, size_t n)
+{
+  size_t i = 0;
+  while (i < n && read_branch(&records[i]))
+  {
+    i++;
+  }
+  return i;
+}
+
+// Estimated CPI of a region with known instructions that lost
+// 'stall_cycles' to mispredictions
+//
+double region_cpi(const region_stats *stats, uint64_t stall_cycles)
+{
+  return 1.0 / fetch_width + (double)stall_cycles / (double)stats->instructions;
+}
+
+// Print the mispredict statistics of one region
+//
+void print_region(region_stats *stats)
+{
+  printf("Branches:        %10llu\n", (unsigned long long)stats->num_branches);
+  printf("Incorrect:       %10llu\n", (unsigned long long)stats->mispredictions);
+  float mispredict_rate = 1000 * ((float)stats->mispredictions / (float)stats->num_branches);
+  printf("Misprediction Rate: %7.3f\n", mispredict_rate);
+
+  if (stats->instructions > 0)
+  {
+    float mpki = 1000 * ((float)stats->mispredictions / (float)stats->instructions);
+    float cpi = (float)stats->stall_cycles / (float)stats->instructions;
+    printf("Instructions:    %10llu\n", (unsigned long long)stats->instructions);
+    printf("MPKI:               %7.3f\n", mpki);
+    printf("Mispredict CPI:     %7.3f (%d cycle penalty", cpi, mispredict_penalty);
+    if (pipeline_depth > 0 && has_inst_deltas)
+      printf(", depth %d", pipeline_depth);
+    if (overrideType != OVERRIDE_NONE)
+      printf(", override bubbles");
+    printf(")\n");
+    printf("CPI:                %7.3f (fetch width %d)\n", region_cpi(stats, stats->stall_cycles), fetch_width);
+  }
+}
+
+// Fill in the instruction count of a region that the trace gave no
+// per-branch deltas for, scaling the trace total by its share of the
+// conditional branches
+//
+void estimate_instructions(region_stats *stats, uint64_t total_branches)
+{
+  uint64_t instructions = (instructions_override > 0) ? instructions_override : info.instructions;
+  if (has_inst_deltas || instructions == 0)
+  {
+    return;
+  }
+  uint64_t branches = info.conditional > 0 ? info.conditional : total_branches;
+  stats->instructions = (uint64_t)((double)instructions * stats->num_branches / branches);
+}
+
+// Open the interval statistics stream
+//
+void open_intervals()
+{
+  interval_stream = stderr;
+  if (interval_path != NULL)
+  {
+    interval_stream = fopen(interval_path, "w");
+    if (interval_stream == NULL)
+    {
+      printf("Unable to open interval output %s\n", interval_path);
+      exit(1);
+    }
+    // Intervals are small; let stdio batch them into large writes
+    setvbuf(interval_stream, NULL, _IOFBF, 1 << 16);
+  }
+}
+
+// Write one interval line covering the branches since the last one
+//
+void write_interval(uint64_t index, uint64_t records, region_stats *interval)
+{
+  // The baseline process hands its intervals back as they are
+  if (baseline_run)
+  {
+    fwrite(interval, sizeof(region_stats), 1, baseline_file);
+    memset(interval, 0, sizeof(region_stats));
+    return;
+  }
+
+  // The header waits for the first records, which tell whether the
+  // trace carries instruction deltas. Without them the trace summary's
+  // instructions per conditional branch stand in, as for the whole run.
+  int has_instructions = has_inst_deltas ||
+                         ((instructions_override > 0 || info.instructions > 0) && info.conditional > 0);
+  int speedup = has_instructions && baseline_spec != NULL;
+  if (index == 0)
+  {
+    fprintf(interval_stream, "interval,records,branches,mispredictions,mispredict_rate%s%s\n",
+            has_instructions ? ",instructions,mpki,cpi" : "", speedup ? ",speedup" : "");
+  }
+  estimate_instructions(interval, info.conditional);
+  float mispredict_rate = 1000 * ((float)interval->mispredictions / (float)interval->num_branches);
+  fprintf(interval_stream, "%llu,%llu,%llu,%llu,%.3f",
+          (unsigned long long)index, (unsigned long long)records,
+          (unsigned long long)interval->num_branches,
+          (unsigned long long)interval->mispredictions, mispredict_rate);
+  if (has_instructions)
+  {
+    float mpki = 1000 * ((float)interval->mispredictions / (float)interval->instructions);
+    fprintf(interval_stream, ",%llu,%.3f,%.3f", (unsigned long long)interval->instructions, mpki,
+            region_cpi(interval, interval->stall_cycles));
+  }
+  if (speedup && index < num_baseline_intervals)
+  {
+    fprintf(interval_stream, ",%.3f", region_cpi(interval, baseline_intervals[index].stall_cycles) /
+                                         region_cpi(interval, interval->stall_cycles));
+  }
+  fputc('\n', interval_stream);
+  memset(interval, 0, sizeof(region_stats));
+}
+
+// Fetch cycles lost to a misprediction
+//
+uint64_t mispredict_stall()
+{
+  uint64_t stall = mispredict_penalty;
+  if (pipeline_depth > 0 && has_inst_deltas)
+  {
+    uint64_t refetch = pipeline_depth + (insts_since_redirect + fetch_width - 1) / fetch_width;
+    if (refetch < stall)
+      stall = refetch;
+  }
+  insts_since_redirect = 0;
+  return stall;
+}
+
+// Account the prediction for a resolved record
+//
+void score_branch(const br_record *r, uint32_t prediction)
+{
+  // Records inside the warmup window are scored separately
+  region_stats *stats = (num_records++ < warmup_records) ? &warmup : &measured;
+  stats->instructions += r->insts;
+  interval.instructions += r->insts;
+  insts_since_redirect += r->insts;
+  if (r->condition == 1)
+  {
+    stats->num_branches++;
+    // Compare the prediction with the actual outcome
+    if (prediction != r->outcome)
+    {
+      uint64_t stall = mispredict_stall();
+      stats->mispredictions++;
+      stats->stall_cycles += stall;
+      interval.mispredictions++;
+      interval.stall_cycles += stall;
+    }
+    if (top_branches > 0 && stats == &measured)
+    {
+      profile_branch(r->pc, r->outcome, prediction);
+    }
+    if (++interval.num_branches == interval_branches)
+    {
+      write_interval(num_intervals++, num_records, &interval);
+    }
+    if (verbose != 0)
+    {
+      printf("%d\n", prediction);
+    }
+  }
+}
+
+// Append one confidence bit to the confidence stream
+//
+void write_confidence_bit(int high)
+{
+  conf_word |= (uint64_t)high << conf_word_bits;
+  if (++conf_word_bits == 64)
+  {
+    fwrite(&conf_word, sizeof(conf_word), 1, conf_stream);
+    conf_word = 0;
+    conf_word_bits = 0;
+  }
+}
+
+// Grade a resolved conditional branch and train the estimator
+//
+void score_confidence(inflight_branch *b, int measure)
+{
+  br_record *r = &b->rec;
+  uint8_t correct = b->prediction == r->outcome;
+  if (measure)
+  {
+    account_confidence(b->confidence, correct);
+  }
+  if (conf_stream != NULL)
+  {
+    write_confidence_bit(b->confidence >= confThreshold);
+  }
+  train_confidence(r->pc, &b->ctx, correct);
+}
+
+// Score a resolved branch and update the predictor with its outcome
+//
+void retire_branch(inflight_branch *b)
+{
+  br_record *r = &b->rec;
+  int measure = num_records >= warmup_records;
+  if (confType != CONF_NONE && r->condition == 1)
+  {
+    score_confidence(b, measure);
+  }
+  if (oracle_enabled && r->condition == 1)
+  {
+    oracle_branch(r->pc, &b->ctx, r->outcome, measure);
+  }
+  uint32_t prediction = b->fallback ? TAKEN : b->prediction;
+  if (b->fallback)
+  {
+    account_fallback(b->prediction, r->outcome);
+  }
+  if (overrideType != OVERRIDE_NONE && r->condition == 1)
+  {
+    // Refetching after an override costs cycles like a misprediction
+    int bubbles = account_override(b->fast, prediction, r->outcome, measure);
+    (measure ? &measured : &warmup)->stall_cycles += bubbles;
+    interval.stall_cycles += bubbles;
+    override_train(b->fast_index, r->outcome);
+  }
+  if (flushStructures != 0 && r->condition == 1)
+  {
+    account_flush_branch(prediction == r->outcome, measure);
+  }
+  score_branch(r, prediction);
+  // Train the predictor
+  train_predictor_ctx(r->pc, r->target, r->outcome, r->condition, r->call, r->ret, r->direct, &b->ctx);
+}
+
+// Make a prediction for a branch entering the window. Refetched branches
+// take the same path, so they claim bank ports again in the bundles
+// fetch forms after the redirect.
+//
+void fetch_branch(inflight_branch *b)
+{
+  br_record *r = &b->rec;
+  if (r->condition == 1)
+  {
+    b->prediction = make_prediction_ctx(r->pc, r->target, r->direct, &b->ctx);
+    if (overrideType != OVERRIDE_NONE)
+    {
+      b->fast = override_predict(r->pc, &b->fast_index);
+    }
+    if (confType != CONF_NONE)
+    {
+      b->confidence = estimate_confidence(r->pc, &b->ctx);
+    }
+  }
+  b->fallback = (numBanks > 0) ? bank_fetch(r, &b->ctx) : 0;
+}
+
+// Resolve the oldest in-flight branch. With speculative histories a
+// misprediction squashes all younger branches, since they were predicted
+// with a wrong history, and fetches them again once the history has been
+// repaired.
+//
+void resolve_oldest()
+{
+  inflight_branch *b = &inflight[head % window];
+  int squash = spec_history && b->rec.condition == 1 && b->prediction != b->rec.outcome;
+  if (squash)
+  {
+    for (uint64_t i = tail - 1; i > head; i--)
+    {
+      inflight_branch *younger = &inflight[i % window];
+      if (younger->rec.condition == 1)
+      {
+        squash_prediction(younger->rec.pc, &younger->ctx);
+        num_squashed++;
+      }
+    }
+  }
+
+  retire_branch(b);
+  head++;
+
+  if (squash)
+  {
+    for (uint64_t i = head; i < tail; i++)
+    {
+      fetch_branch(&inflight[i % window]);
+    }
+  }
+}
+
+// Set up the in-flight window. Branches are predicted in trace order and
+// resolved in the same order once 'resolve_delay' younger records have
+// been predicted.
+//
+void start_pipeline()
+{
+  window = resolve_delay + 1;
+  inflight = (inflight_branch *)calloc(window, sizeof(inflight_branch));
+  head = 0;
+  tail = 0;
+}
+
+// Predict the next record with the tables as they are right now
+//
+void pipeline_push(const br_record *r)
+{
+  if (flushStructures != 0 && flush_due(r))
+  {
+    // Like a barrier, the flush waits for the older branches
+    while (head < tail)
+    {
+      resolve_oldest();
+    }
+    flush_now(num_records >= warmup_records);
+  }
+  inflight_branch *b = &inflight[tail % window];
+  b->rec = *r;
+  fetch_branch(b);
+  if (++tail - head == window)
+  {
+    resolve_oldest();
+  }
+}
+
+// Resolve the branches still in flight
+//
+void finish_pipeline()
+{
+  while (head < tail)
+  {
+    resolve_oldest();
+  }
+  free(inflight);
+}
+
+double now_seconds()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Read the remaining trace into memory
+//
+// Returns the records and sets 'n' to their number
+//
+br_record *load_records(size_t *n)
+{
+  size_t capacity = 1 << 20;
+  br_record *records = (br_record *)malloc(capacity * sizeof(br_record));
+  *n = 0;
+  size_t got;
+  while ((got = read_batch(records + *n, capacity - *n)) > 0)
+  {
+    *n += got;
+    if (*n == capacity)
+    {
+      capacity *= 2;
+      records = (br_record *)realloc(records, capacity * sizeof(br_record));
+    }
+  }
+  return records;
+}
+
+// Predict and train records [begin, end) of an in-memory trace, scoring
+// them when 'score' is set
+//
+void simulate_records(const br_record *records, size_t begin, size_t end, int score)
+{
+  uint64_t predictions[BATCH_RECORDS / 64];
+  for (size_t i = begin; i < end; i += BATCH_RECORDS)
+  {
+    size_t n = (end - i < BATCH_RECORDS) ? end - i : BATCH_RECORDS;
+    predict_train_batch(records + i, n, predictions);
+    for (size_t j = 0; score && j < n; j++)
+    {
+      score_branch(&records[i + j], (predictions[j >> 6] >> (j & 63)) & 1);
+    }
+  }
+}
+
+// Every branch updates the predictor before the next one is predicted,
+// and no model needs the prediction contexts
+//
+// Returns True if records can be simulated in batches
+//
+int batch_mode()
+{
+  return resolve_delay == 0 && !spec_history && confType == CONF_NONE && !oracle_enabled && numBanks == 0 &&
+         overrideType == OVERRIDE_NONE && flushStructures == 0;
+}
+
+// Simulate records [begin, end) of an in-memory trace with the
+// configured pipeline; branches still in flight at 'end' are resolved
+//
+void run_records(const br_record *records, size_t begin, size_t end)
+{
+  if (batch_mode())
+  {
+    simulate_records(records, begin, end, 1);
+    return;
+  }
+  start_pipeline();
+  for (size_t i = begin; i < end; i++)
+  {
+    pipeline_push(&records[i]);
+  }
+  finish_pipeline();
+}
+
+// Give a forked worker a fresh predictor, warmed from the snapshot if
+// one was requested, and fresh banks
+//
+void init_worker_predictor()
+{
+  init_predictor();
+  if (numBanks > 0)
+  {
+    init_banks();
+  }
+  if (overrideType != OVERRIDE_NONE)
+  {
+    init_override();
+  }
+  init_flush(0);
+  if (load_state_path != NULL)
+  {
+    FILE *state = fopen(load_state_path, "rb");
+    if (state == NULL || !load_predictor(state))
+    {
+      _exit(1);
+    }
+    fclose(state);
+  }
+}
+
+// Simulate an in-memory trace as 'parallel_chunks' independent chunks,
+// one forked worker each, and merge their statistics. Worker 'k' (with
+// --parallel-check) simulates the whole trace serially for comparison.
+//
+void simulate_parallel(const br_record *records, size_t n)
+{
+  int workers = parallel_chunks + parallel_check;
+  chunk_result *results = (chunk_result *)mmap(NULL, workers * sizeof(chunk_result),
+                                                PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (results == MAP_FAILED)
+  {
+    printf("Unable to map shared memory for parallel workers\n");
+    exit(1);
+  }
+  memset(results, 0, workers * sizeof(chunk_result));
+
+  double start = now_seconds();
+  for (int k = 0; k < workers; k++)
+  {
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+      printf("Unable to fork parallel worker\n");
+      exit(1);
+    }
+    if (pid > 0)
+    {
+      continue;
+    }
+
+    // Worker: chunk boundaries are split evenly over the records
+    double worker_start = now_seconds();
+    size_t begin = (k < parallel_chunks) ? n * k / parallel_chunks : 0;
+    size_t end = (k < parallel_chunks) ? n * (k + 1) / parallel_chunks : n;
+    size_t warm = (begin > parallel_warmup) ? begin - parallel_warmup : 0;
+    init_worker_predictor();
+    simulate_records(records, warm, begin, 0);
+    num_records = begin;
+    simulate_records(records, begin, end, 1);
+
+    results[k].warmup = warmup;
+    results[k].measured = measured;
+    results[k].seconds = now_seconds() - worker_start;
+    results[k].done = 1;
+    _exit(0);
+  }
+
+  int status;
+  while (wait(&status) > 0)
+  {
+  }
+  double elapsed = now_seconds() - start;
+
+  for (int k = 0; k < parallel_chunks; k++)
+  {
+    if (!results[k].done)
+    {
+      printf("Parallel worker %d failed\n", k);
+      exit(1);
+    }
+    warmup.num_branches += results[k].warmup.num_branches;
+    warmup.mispredictions += results[k].warmup.mispredictions;
+    warmup.instructions += results[k].warmup.instructions;
+    warmup.stall_cycles += results[k].warmup.stall_cycles;
+    measured.num_branches += results[k].measured.num_branches;
+    measured.mispredictions += results[k].measured.mispredictions;
+    measured.instructions += results[k].measured.instructions;
+    measured.stall_cycles += results[k].measured.stall_cycles;
+  }
+  num_records = n;
+
+  printf("Parallel:        %10d chunks, %llu warmup records, %.2f s\n", parallel_chunks,
+         (unsigned long long)parallel_warmup, elapsed);
+  if (parallel_check)
+  {
+    chunk_result *serial = &results[parallel_chunks];
+    if (!serial->done)
+    {
+      printf("Serial check failed\n");
+      exit(1);
+    }
+    int64_t error = (int64_t)measured.mispredictions - (int64_t)serial->measured.mispredictions;
+    printf("Serial:          %10llu incorrect, %.2f s\n",
+           (unsigned long long)serial->measured.mispredictions, serial->seconds);
+    if (serial->measured.mispredictions > 0)
+    {
+      printf("Parallel error:  %+10lld (%+.3f%%)\n", (long long)error,
+             100 * ((double)error / (double)serial->measured.mispredictions));
+    }
+    else
+    {
+      // No relative error against a run without mispredictions
+      printf("Parallel error:  %+10lld\n", (long long)error);
+    }
+  }
+  munmap(results, workers * sizeof(chunk_result));
+}
+
+// Identify the trace and the build for the results database
+//
+// Returns True if results can be recorded
+//
+int open_results()
+{
+  if (results_db_path == NULL || trace_path == NULL)
+    return 0;
+  if (!hash_file(trace_path, &trace_hash) || !hash_file("/proc/self/exe", &build_hash))
+  {
+    printf("Warning: unable to fingerprint the run, results are not recorded\n");
+    return 0;
+  }
+  return 1;
+}
+
+// Write the configuration key of the run: the canonical predictor spec
+// and every option that changes the statistics
+//
+void result_key(char *key, size_t size)
+{
+  bp_config cfg;
+  char spec[MAX_SPEC_LEN];
+  get_config(&cfg);
+  format_predictor_spec(&cfg, spec, sizeof(spec));
+
+  // A warm start depends on the snapshot contents
+  uint64_t state_hash = 0;
+  if (load_state_path != NULL && !hash_file(load_state_path, &state_hash))
+    state_hash = 0;
+  snprintf(key, size, "%s warmup=%llu delay=%u spec-history=%d parallel=%d parallel-warmup=%llu state=%016llx "
+                      "penalty=%d depth=%d width=%d banks=%d ports=%d bundle=%d block=%d fallback=%d "
+                      "override=%s:%d,%d flush=%d,%llu,%d",
+           spec, (unsigned long long)warmup_records, resolve_delay, spec_history, parallel_chunks,
+           (unsigned long long)parallel_warmup, (unsigned long long)state_hash, mispredict_penalty,
+           pipeline_depth, fetch_width, numBanks, bankPorts, bundleWidth, fetchBlock, bankFallback,
+           overrideName[overrideType], overrideBits, overrideLatency, flushStructures,
+           (unsigned long long)flushInterval, flushAtEvents);
+}
+
+// The region statistics before instruction estimates, and the trace
+// summary they are estimated from
+//
+void pack_results(uint64_t *values)
+{
+  uint64_t packed[NUM_RESULT_VALUES] = {
+      warmup.num_branches, warmup.mispredictions, warmup.instructions,
+      measured.num_branches, measured.mispredictions, measured.instructions,
+      num_squashed, (uint64_t)has_inst_deltas, num_records,
+      info.instructions, info.unconditional, info.conditional, info.calls, info.returns,
+      warmup.stall_cycles, measured.stall_cycles};
+  memcpy(values, packed, sizeof(packed));
+}
+
+void unpack_results(const uint64_t *values)
+{
+  warmup.num_branches = values[0];
+  warmup.mispredictions = values[1];
+  warmup.instructions = values[2];
+  measured.num_branches = values[3];
+  measured.mispredictions = values[4];
+  measured.instructions = values[5];
+  num_squashed = values[6];
+  has_inst_deltas = (int)values[7];
+  num_records = values[8];
+  warmup.stall_cycles = values[14];
+  measured.stall_cycles = values[15];
+
+  // A sidecar read for this run takes precedence
+  uint64_t *fields[5] = {&info.instructions, &info.unconditional, &info.conditional, &info.calls, &info.returns};
+  for (int i = 0; i < 5; i++)
+  {
+    if (*fields[i] == 0)
+      *fields[i] = values[9 + i];
+  }
+}
+
+// Look the configured run up in the results database
+//
+// Returns True if its statistics were restored
+//
+int lookup_run()
+{
+  char key[MAX_SPEC_LEN + 256];
+  uint64_t values[NUM_RESULT_VALUES];
+  result_key(key, sizeof(key));
+  if (force_simulation || !lookup_result(results_db_path, trace_hash, build_hash, key, values, NUM_RESULT_VALUES))
+    return 0;
+  unpack_results(values);
+  return 1;
+}
+
+void record_run()
+{
+  char key[MAX_SPEC_LEN + 256];
+  uint64_t values[NUM_RESULT_VALUES];
+  uint64_t recorded[NUM_RESULT_VALUES];
+  result_key(key, sizeof(key));
+  pack_results(values);
+  // Runs the database already has as they are add no line
+  if (lookup_result(results_db_path, trace_hash, build_hash, key, recorded, NUM_RESULT_VALUES) &&
+      !memcmp(values, recorded, sizeof(values)))
+  {
+    return;
+  }
+  if (!record_result(results_db_path, trace_hash, build_hash, key, values, NUM_RESULT_VALUES))
+  {
+    printf("Warning: unable to record results in %s\n", results_db_path);
+  }
+}
+
+// Read the job lines of a sweep file, skipping blanks and # comments
+//
+void read_sweep_jobs(const char *path)
+{
+  FILE *f = fopen(path, "r");
+  if (f == NULL)
+  {
+    printf("Unable to open sweep file %s\n", path);
+    exit(1);
+  }
+  int capacity = 16;
+  sweep_jobs = (char **)malloc(capacity * sizeof(char *));
+  char *line = NULL;
+  size_t line_len = 0;
+  while (getline(&line, &line_len, f) != -1)
+  {
+    line[strcspn(line, "#\r\n")] = '\0';
+    if (strspn(line, " \t") == strlen(line))
+      continue;
+    if (num_sweep_jobs == capacity)
+    {
+      capacity *= 2;
+      sweep_jobs = (char **)realloc(sweep_jobs, capacity * sizeof(char *));
+    }
+    sweep_jobs[num_sweep_jobs++] = strdup(line);
+  }
+  free(line);
+  fclose(f);
+}
+
+// Apply the options of sweep job 'job' on top of the command line in a
+// worker, which only reports region statistics
+//
+// Returns True if the predictor fits the storage budget and cycle time
+//
+int apply_job_options(int job, sweep_result *out)
+{
+  char *options = strdup(sweep_jobs[job]);
+  for (char *arg = strtok(options, " \t"); arg != NULL; arg = strtok(NULL, " \t"))
+  {
+    if (!handle_option(arg))
+    {
+      printf("Job %d: unrecognized option %s\n", job, arg);
+      fflush(stdout);
+      _exit(2);
+    }
+  }
+
+  out->budget = predictor_budget();
+  if (budget_bits > 0 && out->budget > budget_bits)
+  {
+    out->over_budget = 1;
+    return 0;
+  }
+  out->access_ps = predictor_access_time(NULL);
+  if (cycleTime > 0 && out->access_ps > cycleTime)
+  {
+    out->over_timing = 1;
+    return 0;
+  }
+  verbose = 0;
+  top_branches = 0;
+  interval_branches = 0;
+  confType = CONF_NONE;
+  oracle_enabled = 0;
+  return 1;
+}
+
+// Body of a sweep worker: apply the job's options and simulate the
+// shared trace
+//
+void run_sweep_job(int job, void *result)
+{
+  sweep_result *out = (sweep_result *)result;
+  if (!apply_job_options(job, out))
+  {
+    return;
+  }
+
+  // The results database may already have the job
+  int recording = results_db_path != NULL && trace_hash != 0;
+  if (recording && lookup_run())
+  {
+    out->cached = 1;
+  }
+  else
+  {
+    init_worker_predictor();
+    run_records(sweep_records, 0, num_sweep_records);
+    if (recording)
+    {
+      record_run();
+    }
+  }
+
+  out->warmup = warmup;
+  out->measured = measured;
+  out->squashed = num_squashed;
+}
+
+// Snapshot file of a sweep job between halving rounds
+//
+void halving_state_path(int job, char *path, size_t size)
+{
+  snprintf(path, size, "%s/job%d.state", halving_dir, job);
+}
+
+// Body of a halving worker: continue the job's predictor from where the
+// previous round left it, and keep it for the next round
+//
+void run_halving_job(int slot, void *result)
+{
+  int job = halving_jobs[slot];
+  sweep_result *out = (sweep_result *)result;
+  if (!apply_job_options(job, out))
+  {
+    return;
+  }
+
+  char path[64];
+  halving_state_path(job, path, sizeof(path));
+  if (halving_begin == 0)
+  {
+    init_worker_predictor();
+  }
+  else
+  {
+    init_predictor();
+    FILE *state = fopen(path, "rb");
+    if (state == NULL || !load_predictor(state))
+    {
+      _exit(1);
+    }
+    fclose(state);
+    warmup = halving_progress[job].warmup;
+    measured = halving_progress[job].measured;
+    num_squashed = halving_progress[job].squashed;
+    num_records = halving_begin;
+    init_flush(warmup.num_branches + measured.num_branches);
+  }
+  run_records(sweep_records, halving_begin, halving_end);
+  if (!halving_last)
+  {
+    FILE *state = fopen(path, "wb");
+    if (state == NULL || !save_predictor(state))
+    {
+      _exit(1);
+    }
+    fclose(state);
+  }
+
+  out->warmup = warmup;
+  out->measured = measured;
+  out->squashed = num_squashed;
+}
+
+// Rank the jobs of a halving round: fewest mispredictions in the
+// measured region first, or in the warmup while the prefix is shorter
+//
+int compare_halving(const void *a, const void *b)
+{
+  const sweep_result *x = &halving_progress[*(const int *)a];
+  const sweep_result *y = &halving_progress[*(const int *)b];
+  uint64_t mx = x->measured.num_branches ? x->measured.mispredictions : x->warmup.mispredictions;
+  uint64_t my = y->measured.num_branches ? y->measured.mispredictions : y->warmup.mispredictions;
+  if (mx != my)
+    return (mx > my) - (mx < my);
+  return *(const int *)a - *(const int *)b;
+}
+
+// Run the sweep jobs with successive halving and print one line per
+// job, the jobs that got furthest first
+//
+void simulate_halving()
 {
-  fprintf(stderr, "Usage: predictor <options> [<trace>]\n");
-  fprintf(stderr, "       bunzip2 -kc trace.bz2 | predictor <options>\n");
-  fprintf(stderr, " Options:\n");
-  fprintf(stderr, " --help       Print this message\n");
-  fprintf(stderr, " --verbose    Print predictions on stdout\n");
-  fprintf(stderr, " --<type>     Branch prediction scheme:\n");
-  fprintf(stderr, "    static\n"
-                  "    gshare\n"
-                  "    tournament\n"
-                  "    custom\n");
+  int n = num_sweep_jobs;
+  if (halving_keep < 1)
+  {
+    halving_keep = 1;
+  }
+
+  // Round r runs the first n / halving_rate^(rounds-1-r) records, but
+  // at least halving_min of them; rounds that end up no longer than the
+  // one before only drop more jobs
+  int rounds = 1;
+  for (int alive = n; alive > halving_keep; alive = (alive + halving_rate - 1) / halving_rate)
+  {
+    rounds++;
+  }
+  size_t *ends = (size_t *)malloc(rounds * sizeof(size_t));
+  ends[rounds - 1] = num_sweep_records;
+  for (int r = rounds - 2; r >= 0; r--)
+  {
+    ends[r] = ends[r + 1] / halving_rate;
+  }
+  for (int r = 0; r < rounds; r++)
+  {
+    if (ends[r] < halving_min)
+      ends[r] = (halving_min < num_sweep_records) ? halving_min : num_sweep_records;
+  }
+
+  if (mkdtemp(halving_dir) == NULL)
+  {
+    printf("Unable to create a directory for predictor snapshots\n");
+    exit(1);
+  }
+  halving_jobs = (int *)malloc(n * sizeof(int));
+  halving_progress = (sweep_result *)calloc(n, sizeof(sweep_result));
+  job_status *final_status = (job_status *)calloc(n, sizeof(job_status));
+  int *reached = (int *)calloc(n, sizeof(int)); // rounds run by every job
+
+  // Print order: jobs that got further first, then by mispredictions,
+  // and failed jobs last. Jobs are ranked from the back as they drop out.
+  int *order = (int *)malloc(n * sizeof(int));
+  int *failed = (int *)malloc(n * sizeof(int));
+  int ranked = n, num_failed = 0;
+  for (int j = 0; j < n; j++)
+  {
+    halving_jobs[j] = j;
+  }
+
+  int alive = n;
+  uint64_t simulated = 0;
+  halving_begin = 0;
+  for (int r = 0; r < rounds && alive > 0; r++)
+  {
+    halving_end = ends[r];
+    halving_last = r == rounds - 1;
+    job_status *status = run_sweep(alive, sweep_workers, sweep_timeout, sweep_retries,
+                                   sizeof(sweep_result), run_halving_job);
+    if (status == NULL)
+    {
+      printf("Unable to map shared memory for sweep results\n");
+      exit(1);
+    }
+    simulated += (uint64_t)alive * (halving_end - halving_begin);
+
+    // Failed, over-budget and too slow jobs drop out right away
+    int ok = 0;
+    for (int i = 0; i < alive; i++)
+    {
+      int job = halving_jobs[i];
+      job_status *js = job_slot(status, sizeof(sweep_result), i);
+      sweep_result *res = (sweep_result *)job_result(status, sizeof(sweep_result), i);
+      int attempts = final_status[job].attempts + js->attempts;
+      double seconds = final_status[job].seconds + js->seconds;
+      final_status[job] = *js;
+      final_status[job].attempts = attempts;
+      final_status[job].seconds = seconds;
+      halving_progress[job] = *res;
+      reached[job] = r + 1;
+      if (js->state == JOB_DONE && !res->over_budget && !res->over_timing)
+      {
+        halving_jobs[ok++] = job;
+      }
+      else
+      {
+        failed[num_failed++] = job;
+      }
+    }
+    free_sweep(status, alive, sizeof(sweep_result));
+
+    qsort(halving_jobs, ok, sizeof(int), compare_halving);
+    int keep = (ok + halving_rate - 1) / halving_rate;
+    alive = (keep < halving_keep) ? ((ok < halving_keep) ? ok : halving_keep) : keep;
+    ranked -= ok - alive;
+    memcpy(order + ranked, halving_jobs + alive, (ok - alive) * sizeof(int));
+    for (int i = alive; i < ok; i++)
+    {
+      char path[64];
+      halving_state_path(halving_jobs[i], path, sizeof(path));
+      unlink(path);
+    }
+    halving_begin = halving_end;
+  }
+  for (int j = 0; j < n; j++)
+  {
+    char path[64];
+    halving_state_path(j, path, sizeof(path));
+    unlink(path);
+  }
+  rmdir(halving_dir);
+  ranked -= alive;
+  memcpy(order + ranked, halving_jobs, alive * sizeof(int));
+  memmove(order, order + ranked, (n - ranked) * sizeof(int));
+  memcpy(order + n - ranked, failed, num_failed * sizeof(int));
+
+  const char *state_names[] = {"pending", "done", "failed", "timeout"};
+  printf("%4s  %-8s  %5s  %5s  %8s  %10s  %9s  %10s  %10s  %7s  %s\n", "Job", "Status", "Tries", "Round",
+         "Seconds", "Bits", "Access ps", "Branches", "Incorrect", "Rate", "Options");
+  for (int i = 0; i < n; i++)
+  {
+    int j = order[i];
+    job_status *js = &final_status[j];
+    sweep_result *res = &halving_progress[j];
+    int over_budget = js->state == JOB_DONE && res->over_budget;
+    int over_timing = js->state == JOB_DONE && res->over_timing;
+    region_stats *stats = res->measured.num_branches ? &res->measured : &res->warmup;
+    printf("%4d  %-8s  %5d  %5d  %8.2f", j,
+           over_budget ? "budget" : over_timing ? "timing" : state_names[js->state], js->attempts, reached[j],
+           js->seconds);
+    if (js->state == JOB_DONE && !over_budget)
+    {
+      printf("  %10llu  %9.1f", (unsigned long long)res->budget, res->access_ps);
+    }
+    else if (js->state == JOB_DONE)
+    {
+      printf("  %10llu  %9s", (unsigned long long)res->budget, "-");
+    }
+    else
+    {
+      printf("  %10s  %9s", "-", "-");
+    }
+    if (js->state == JOB_DONE && !over_budget && !over_timing)
+    {
+      printf("  %10llu  %10llu  %7.3f", (unsigned long long)stats->num_branches,
+             (unsigned long long)stats->mispredictions,
+             1000 * ((float)stats->mispredictions / (float)stats->num_branches));
+    }
+    else
+    {
+      printf("  %10s  %10s  %7s", "-", "-", "-");
+    }
+    printf("  %s\n", sweep_jobs[j]);
+  }
+  printf("Halving:         %d rounds, %llu of %llu records simulated (%.1f%% of a full sweep)\n", rounds,
+         (unsigned long long)simulated, (unsigned long long)n * num_sweep_records,
+         100.0 * simulated / ((double)n * num_sweep_records + (n * num_sweep_records == 0)));
+
+  free(order);
+  free(failed);
+  free(reached);
+  free(final_status);
+  free(halving_progress);
+  free(halving_jobs);
+  free(ends);
 }
 
-// Process an option and update the predictor
-// configuration variables accordingly
+// Run the jobs of the sweep file over the trace and print one line per
+// job
 //
-// Returns True if Successful
+void simulate_sweep()
+{
+  read_sweep_jobs(sweep_path);
+  // Partial runs of a halving sweep are not recorded
+  if (halving_rate > 0 || !open_results())
+  {
+    trace_hash = 0;
+  }
+
+  // Decode the trace once into a read-only segment all workers share
+  size_t n;
+  br_record *records = load_records(&n);
+  size_t bytes = n * sizeof(br_record) + 1;
+  br_record *shared = (br_record *)shared_alloc(bytes);
+  if (shared == NULL)
+  {
+    printf("Unable to map shared memory for the trace\n");
+    exit(1);
+  }
+  memcpy(shared, records, n * sizeof(br_record));
+  free(records);
+  shared_seal(shared, bytes);
+  sweep_records = shared;
+  num_sweep_records = n;
+
+  if (sweep_workers <= 0)
+  {
+    sweep_workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  }
+  if (halving_rate > 0)
+  {
+    simulate_halving();
+    shared_free(shared, bytes);
+    return;
+  }
+  job_status *status = run_sweep(num_sweep_jobs, sweep_workers, sweep_timeout, sweep_retries,
+                                 sizeof(sweep_result), run_sweep_job);
+  if (status == NULL)
+  {
+    printf("Unable to map shared memory for sweep results\n");
+    exit(1);
+  }
+
+  const char *state_names[] = {"pending", "done", "failed", "timeout"};
+  printf("%4s  %-8s  %5s  %8s  %10s  %9s  %10s  %10s  %7s  %s\n", "Job", "Status", "Tries", "Seconds",
+         "Bits", "Access ps", "Branches", "Incorrect", "Rate", "Options");
+  for (int j = 0; j < num_sweep_jobs; j++)
+  {
+    job_status *js = job_slot(status, sizeof(sweep_result), j);
+    sweep_result *r = (sweep_result *)job_result(status, sizeof(sweep_result), j);
+    int over_budget = js->state == JOB_DONE && r->over_budget;
+    int over_timing = js->state == JOB_DONE && r->over_timing;
+    int cached = js->state == JOB_DONE && r->cached;
+    printf("%4d  %-8s  %5d  %8.2f", j,
+           over_budget ? "budget" : over_timing ? "timing" : cached ? "cached" : state_names[js->state],
+           js->attempts, js->seconds);
+    if (js->state == JOB_DONE && !over_budget)
+    {
+      printf("  %10llu  %9.1f", (unsigned long long)r->budget, r->access_ps);
+    }
+    else if (js->state == JOB_DONE)
+    {
+      printf("  %10llu  %9s", (unsigned long long)r->budget, "-");
+    }
+    else
+    {
+      printf("  %10s  %9s", "-", "-");
+    }
+    if (js->state == JOB_DONE && !over_budget && !over_timing)
+    {
+      printf("  %10llu  %10llu  %7.3f", (unsigned long long)r->measured.num_branches,
+             (unsigned long long)r->measured.mispredictions,
+             1000 * ((float)r->measured.mispredictions / (float)r->measured.num_branches));
+    }
+    else
+    {
+      printf("  %10s  %10s  %7s", "-", "-", "-");
+    }
+    printf("  %s\n", sweep_jobs[j]);
+  }
+
+  free_sweep(status, num_sweep_jobs, sizeof(sweep_result));
+  shared_free(shared, bytes);
+}
+
+// Simulate the trace with the configured predictor and pipeline
 //
-int handle_option(char *arg)
+void simulate_trace()
 {
-  if (!strcmp(arg, "--static"))
+  // Initialize the predictor
+  init_predictor();
+
+  // Warm the predictor from a previous run
+  if (load_state_path != NULL)
+  {
+    FILE *state = fopen(load_state_path, "rb");
+    if (state == NULL || !load_predictor(state))
+    {
+      printf("Unable to load predictor state from %s\n", load_state_path);
+      exit(1);
+    }
+    fclose(state);
+  }
+
+  if (interval_branches > 0 && !baseline_run)
   {
-    bpType = STATIC;
+    open_intervals();
   }
-  else if (!strncmp(arg, "--gshare", 8))
+  if (top_branches > 0)
   {
-    bpType = GSHARE;
+    init_profiler(12);
   }
-  else if (!strncmp(arg, "--tournament", 12))
+  if (oracle_enabled)
   {
-    bpType = TOURNAMENT;
+    init_oracle();
   }
-  else if (!strncmp(arg, "--custom", 8))
+  if (numBanks > 0)
   {
-    bpType = CUSTOM;
+    init_banks();
   }
-  else if (!strcmp(arg, "--verbose"))
+  if (overrideType != OVERRIDE_NONE)
   {
-    verbose = 1;
+    init_override();
+  }
+  init_flush(0);
+  if (confType != CONF_NONE)
+  {
+    init_confidence();
+    if (conf_out_path != NULL)
+    {
+      conf_stream = fopen(conf_out_path, "wb");
+      if (conf_stream == NULL)
+      {
+        printf("Unable to open confidence output %s\n", conf_out_path);
+        exit(1);
+      }
+    }
+  }
+
+  if (parallel_chunks > 0)
+  {
+    size_t n;
+    br_record *records = load_records(&n);
+    simulate_parallel(records, n);
+    free(records);
+  }
+  else if (batch_mode())
+  {
+    // Every branch updates the predictor before the next one is
+    // predicted, so whole blocks of records can be simulated at once
+    br_record *batch = (br_record *)malloc(BATCH_RECORDS * sizeof(br_record));
+    uint64_t *predictions = (uint64_t *)malloc((BATCH_RECORDS / 64) * sizeof(uint64_t));
+    size_t n;
+    while ((n = read_batch(batch, BATCH_RECORDS)) > 0)
+    {
+      predict_train_batch(batch, n, predictions);
+      for (size_t i = 0; i < n; i++)
+      {
+        score_branch(&batch[i], (predictions[i >> 6] >> (i & 63)) & 1);
+      }
+    }
+    free(batch);
+    free(predictions);
   }
   else
   {
-    return 0;
+    // Reach each branch from the trace; the confidence estimator, the
+    // oracle and the bank model need the prediction contexts only this
+    // path keeps
+    br_record r;
+    start_pipeline();
+    while (read_branch(&r))
+    {
+      pipeline_push(&r);
+    }
+    finish_pipeline();
   }
 
-  return 1;
+  // Flush the trailing partial interval
+  if (interval_branches > 0 && interval.num_branches > 0)
+  {
+    write_interval(num_intervals++, num_records, &interval);
+  }
+  if (interval_stream != NULL && interval_stream != stderr)
+  {
+    fclose(interval_stream);
+  }
 }
 
-// Reads a line from the input stream and extracts the
-// PC and Outcome of a branch
+// Simulate predictor 'cfg' over the trace in a forked process, with the
+// same pipeline, and read back its statistics: the intervals followed by
+// the two regions. The process looks its run up in the results database
+// like the main run.
 //
-// Returns True if Successful
+// Returns the statistics and sets 'n' to their number
 //
-int read_branch(uint32_t *pc, uint32_t *target, uint32_t *outcome, uint32_t *condition, uint32_t *call, uint32_t *ret, uint32_t *direct)
+region_stats *run_reference(const bp_config *cfg, int flushes, int recording, size_t *n)
 {
-  if (getline(&buf, &len, stream) == -1)
+  char spec[MAX_SPEC_LEN];
+  format_predictor_spec(cfg, spec, sizeof(spec));
+  baseline_file = tmpfile();
+  if (baseline_file == NULL)
   {
-    return 0;
+    printf("Unable to create a file for the reference statistics\n");
+    exit(1);
+  }
+
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid < 0)
+  {
+    printf("Unable to fork the reference run\n");
+    exit(1);
+  }
+  if (pid == 0)
+  {
+    // The parent still reads its own copy of the trace
+    stream = open_trace(trace_path);
+    if (stream == NULL)
+    {
+      _exit(1);
+    }
+    set_config(cfg);
+    baseline_run = 1;
+    verbose = 0;
+    load_state_path = NULL;
+    top_branches = 0;
+    oracle_enabled = 0;
+    confType = CONF_NONE;
+    parallel_check = 0;
+    flushStructures = flushes ? flushStructures : 0;
+    int cacheable = recording && interval_branches == 0;
+#ifdef BP_ALIAS_STATS
+    cacheable = 0;
+#endif
+    if (!(cacheable && lookup_run()))
+    {
+      simulate_trace();
+      if (recording)
+      {
+        record_run();
+      }
+    }
+    fwrite(&warmup, sizeof(region_stats), 1, baseline_file);
+    fwrite(&measured, sizeof(region_stats), 1, baseline_file);
+    fflush(baseline_file);
+    _exit(0);
   }
 
-  sscanf(buf, "0x%x\t0x%x\t%d\t%d\t%d\t%d\t%d\n", pc, target, outcome, condition, call, ret, direct);
+  int status;
+  if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+  {
+    printf("Reference run of %s failed\n", spec);
+    exit(1);
+  }
 
-  return 1;
+  rewind(baseline_file);
+  size_t capacity = 64;
+  region_stats *stats = (region_stats *)malloc(capacity * sizeof(region_stats));
+  *n = 0;
+  while (fread(&stats[*n], sizeof(region_stats), 1, baseline_file) == 1)
+  {
+    if (++*n == capacity)
+    {
+      capacity *= 2;
+      stats = (region_stats *)realloc(stats, capacity * sizeof(region_stats));
+    }
+  }
+  fclose(baseline_file);
+  if (*n < 2)
+  {
+    printf("Reference run of %s failed\n", spec);
+    exit(1);
+  }
+  return stats;
+}
+
+// Simulate the baseline predictor, flushed like the main run
+//
+void run_baseline(int recording)
+{
+  bp_config cfg;
+  get_config(&cfg);
+  if (!parse_predictor_spec(baseline_spec, &cfg))
+  {
+    printf("Unrecognized baseline predictor %s\n", baseline_spec);
+    exit(1);
+  }
+  size_t n;
+  region_stats *stats = run_reference(&cfg, 1, recording, &n);
+  baseline_warmup = stats[n - 2];
+  baseline_measured = stats[n - 1];
+  baseline_intervals = stats;
+  num_baseline_intervals = n - 2;
+}
+
+// Simulate the configured predictor without flushes, so their warmup
+// cost is exact
+//
+void run_unflushed(int recording)
+{
+  bp_config cfg;
+  get_config(&cfg);
+  size_t n;
+  region_stats *stats = run_reference(&cfg, 0, recording, &n);
+  unflushed_measured = stats[n - 1];
+  free(stats);
 }
 
 int main(int argc, char *argv[])
@@ -108,52 +1886,263 @@ int main(int argc, char *argv[])
     else
     {
       // Use as input file
-      stream = fopen(argv[i], "r");
+      trace_path = argv[i];
+      stream = open_trace(trace_path);
+      if (stream == NULL)
+      {
+        printf("Unable to open trace %s\n", trace_path);
+        exit(1);
+      }
     }
   }
 
-  // Initialize the predictor
-  init_predictor();
+  // Pick up the trace summary for MPKI reporting
+  if (sidecar_path != NULL)
+  {
+    if (!read_trace_info(sidecar_path, &info))
+    {
+      printf("Unable to read trace summary from %s\n", sidecar_path);
+      exit(1);
+    }
+  }
+  else if (trace_path != NULL)
+  {
+    read_sidecar(trace_path, &info);
+  }
 
-  uint32_t num_branches = 0;
-  uint32_t mispredictions = 0;
-  uint32_t pc = 0;
-  uint32_t target = 0;
-  uint32_t outcome = NOTTAKEN;
-  uint32_t condition = 0;
-  uint32_t call = 0;
-  uint32_t ret = 0;
-  uint32_t direct = 0;
-
-  // Reach each branch from the trace
-  while (read_branch(&pc, &target, &outcome, &condition, &call, &ret, &direct))
-  {
-    if (condition == 1)
-    {
-      num_branches++;
-      // Make a prediction and compare with actual outcome
-      uint32_t prediction = make_prediction(pc, target, direct);
-      if (prediction != outcome)
-      {
-        mispredictions++;
-      }
-      if (verbose != 0)
+  if (halving_rate == 1 || halving_rate < 0)
+  {
+    printf("--halving needs a rate of at least 2\n");
+    exit(1);
+  }
+  if (numBanks > 0 && (bankPorts < 1 || bankPorts > 255 || bundleWidth < 1 || fetchBlock < 1))
+  {
+    printf("--banks needs 1 to 255 ports, and bundles of at least one branch and byte\n");
+    exit(1);
+  }
+  if (overrideType != OVERRIDE_NONE && (overrideBits < 1 || overrideBits > 24 || overrideLatency < 0))
+  {
+    printf("--override needs 1 to 24 index bits and a latency of at least 0 cycles\n");
+    exit(1);
+  }
+#ifdef BP_ACCESS_STATS
+  if (energy_path != NULL && !read_access_energies(energy_path))
+  {
+    printf("Unable to read structure energies from %s\n", energy_path);
+    exit(1);
+  }
+#else
+  if (energy_path != NULL)
+  {
+    printf("--energy needs the build with access counting (make energy)\n");
+    exit(1);
+  }
+#endif
+  if (flushStructures != 0 && flushInterval == 0 && !flushAtEvents)
+  {
+    printf("--flush needs --flush-every or --flush-at-events\n");
+    exit(1);
+  }
+  if (techNode < 1 || cycleTime < 0)
+  {
+    printf("--tech needs a feature size of at least 1 nm, and --cycle-time a positive time\n");
+    exit(1);
+  }
+  if (fetch_width < 1)
+  {
+    printf("--fetch-width needs at least one instruction per cycle\n");
+    exit(1);
+  }
+  if (baseline_spec != NULL && (trace_path == NULL || sweep_path != NULL))
+  {
+    printf("--baseline needs a trace file and cannot be combined with --sweep\n");
+    exit(1);
+  }
+  if (sweep_path != NULL)
+  {
+    simulate_sweep();
+    close_trace(stream, trace_path);
+    free(buf);
+    return 0;
+  }
+
+  if (parallel_chunks > 0)
+  {
+    if (resolve_delay > 0 || spec_history || interval_branches > 0 || verbose || confType != CONF_NONE ||
+        oracle_enabled || numBanks > 0 || overrideType != OVERRIDE_NONE || flushStructures != 0 || save_state_path != NULL)
+    {
+      // Only the workers train, so the parent has no state to save
+      printf("--parallel cannot be combined with --delay, --spec-history, --interval, --verbose, --confidence, --oracle, --banks, --override, --flush or --save-state\n");
+      exit(1);
+    }
+    // Per-branch profiles stay with the workers
+    if (top_branches > 0)
+    {
+      printf("Profile:         skipped for --parallel\n");
+      top_branches = 0;
+    }
+  }
+
+  if (oracle_enabled && bpType == HYBRID)
+  {
+    printf("--oracle does not model hybrid predictors\n");
+    exit(1);
+  }
+
+  // Only simulate predictors that fit the storage budget
+  bp_config cfg;
+  char spec[MAX_SPEC_LEN];
+  get_config(&cfg);
+  format_predictor_spec(&cfg, spec, sizeof(spec));
+  if (storage_report || budget_bits > 0)
+  {
+    printf("Predictor:       %s\n", spec);
+    print_budget();
+  }
+  if (budget_bits > 0 && predictor_budget() > budget_bits)
+  {
+    printf("Predictor storage exceeds the budget of %llu bits\n", (unsigned long long)budget_bits);
+    exit(1);
+  }
+  if (timing_report || cycleTime > 0)
+  {
+    print_timing();
+  }
+  const char *slowest;
+  if (cycleTime > 0 && predictor_access_time(&slowest) > cycleTime)
+  {
+    printf("Predictor structure %s misses the cycle time of %.1f ps\n", slowest, cycleTime);
+    exit(1);
+  }
+
+  // Repeated runs come from the results database
+  int recording = open_results();
+  int cacheable = recording && !verbose && interval_branches == 0 &&
+                  !oracle_enabled && confType == CONF_NONE && numBanks == 0 && overrideType == OVERRIDE_NONE &&
+                  flushStructures == 0 && !parallel_check && save_state_path == NULL;
+#if defined(BP_ALIAS_STATS) || defined(BP_ACCESS_STATS)
+  cacheable = 0;
+#endif
+  if (baseline_spec != NULL)
+  {
+    run_baseline(recording);
+  }
+  has_unflushed = flushStructures != 0 && trace_path != NULL;
+  if (has_unflushed)
+  {
+    run_unflushed(recording);
+  }
+  if (cacheable && lookup_run())
+  {
+    printf("Results:         cached in %s\n", results_db_path);
+    // Only the region statistics are recorded
+    if (top_branches > 0)
+    {
+      printf("Profile:         skipped for cached results (--force to simulate)\n");
+      top_branches = 0;
+    }
+  }
+  else
+  {
+    simulate_trace();
+    if (recording)
+    {
+      record_run();
+    }
+  }
+
+  if (pipeline_depth > 0 && !has_inst_deltas)
+  {
+    printf("Warning: --pipeline-depth needs per-branch instruction deltas, every misprediction costs the full penalty\n");
+  }
+
+  // Without per-branch deltas, fall back to the trace summary
+  if (instructions_override > 0)
+  {
+    info.instructions = instructions_override;
+  }
+  estimate_instructions(&warmup, warmup.num_branches + measured.num_branches);
+  estimate_instructions(&measured, warmup.num_branches + measured.num_branches);
+
+  // Print out the mispredict statistics
+  if (warmup_records > 0)
+  {
+    printf("Warmup (first %llu records):\n", (unsigned long long)warmup_records);
+    print_region(&warmup);
+    printf("Measured:\n");
+  }
+  print_region(&measured);
+  if (baseline_spec != NULL && measured.instructions > 0)
+  {
+    double cpi = region_cpi(&measured, measured.stall_cycles);
+    double baseline_cpi = region_cpi(&measured, baseline_measured.stall_cycles);
+    printf("Baseline CPI:       %7.3f (%s)\n", baseline_cpi, baseline_spec);
+    printf("Speedup:            %7.3f\n", baseline_cpi / cpi);
+  }
+  if (spec_history)
+  {
+    printf("Squashed:        %10llu\n", (unsigned long long)num_squashed);
+  }
+  if (numBanks > 0)
+  {
+    print_bank_stats();
+    cleanup_banks();
+  }
+  if (overrideType != OVERRIDE_NONE)
+  {
+    print_override_stats();
+    cleanup_override();
+  }
+  if (flushStructures != 0)
+  {
+    print_flush_stats(has_unflushed ? &unflushed_measured.mispredictions : NULL);
+  }
+  if (top_branches > 0)
+  {
+    print_profile(top_branches, measured.mispredictions);
+    cleanup_profiler();
+  }
+#ifdef BP_ALIAS_STATS
+  print_alias_stats();
+  cleanup_alias_stats();
+#endif
+#ifdef BP_ACCESS_STATS
+  print_access_stats();
+#endif
+  if (oracle_enabled)
+  {
+    print_oracle(measured.mispredictions);
+    cleanup_oracle();
+  }
+  if (confType != CONF_NONE)
+  {
+    print_confidence_curves();
+    if (conf_stream != NULL)
+    {
+      // The last word is padded with low-confidence bits
+      if (conf_word_bits > 0)
       {
-        printf("%d\n", prediction);
+        fwrite(&conf_word, sizeof(conf_word), 1, conf_stream);
       }
+      fclose(conf_stream);
     }
-    // Train the predictor
-    train_predictor(pc, target, outcome, condition, call, ret, direct);
+    cleanup_confidence();
   }
 
-  // Print out the mispredict statistics
-  printf("Branches:        %10d\n", num_branches);
-  printf("Incorrect:       %10d\n", mispredictions);
-  float mispredict_rate = 1000 * ((float)mispredictions / (float)num_branches);
-  printf("Misprediction Rate: %7.3f\n", mispredict_rate);
+  // Keep the trained predictor for a later run
+  if (save_state_path != NULL)
+  {
+    FILE *state = fopen(save_state_path, "wb");
+    if (state == NULL || !save_predictor(state))
+    {
+      printf("Unable to save predictor state to %s\n", save_state_path);
+      exit(1);
+    }
+    fclose(state);
+  }
 
   // Cleanup
-  fclose(stream);
+  close_trace(stream, trace_path);
   free(buf);
 
   return 0;
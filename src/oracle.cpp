@@ -0,0 +1,170 @@
+//========================================================//
+//  oracle.cpp                                            //
+//  Source file for the interference-free oracle          //
+//                                                        //
+//  Every (PC, history) tuple gets its own counter in an  //
+//  unbounded counter map                                 //
+//========================================================//
+#include <stdio.h>
+#include <stdlib.h>
+#include "oracle.h"
+#include "counter_map.h"
+
+//------------------------------------//
+//       Oracle Data Structures       //
+//------------------------------------//
+
+// Every table of the real predictor becomes a key space of the oracle;
+// a key is the table, the full PC and the history bits the table is
+// indexed with, so no two branches or histories ever share a counter.
+// Each table has its own id in the low three bits of the key. The
+// global and local histories themselves are the real predictor's.
+#define ORACLE_GLOBAL 0  // gshare BHT, tournament GPT
+#define ORACLE_LOCAL 1   // tournament and YAGS LPT
+#define ORACLE_CHOICE 2  // tournament CPT
+#define ORACLE_TCACHE 3  // YAGS T cache
+#define ORACLE_NTCACHE 4 // YAGS NT cache
+
+counter_map oracle_counters;
+
+// Scored branches
+uint64_t oracle_branches;
+uint64_t oracle_mispredictions;
+
+//------------------------------------//
+//         Oracle Functions           //
+//------------------------------------//
+
+uint64_t oracle_key(int table, uint32_t pc, uint64_t history, int historyBits)
+{
+  if (historyBits > 29)
+    historyBits = 29;
+  history &= ((uint64_t)1 << historyBits) - 1;
+  return (history << 35) | ((uint64_t)pc << 3) | (uint64_t)table;
+}
+
+// Find the counter of a key, creating it in state 'init' when 'create'
+// is set
+//
+// Returns NULL if the key has no counter and none was created
+//
+uint8_t *oracle_counter(uint64_t key, uint8_t init, int create)
+{
+  return find_counter(&oracle_counters, key, init, create);
+}
+
+void init_oracle()
+{
+  init_counter_map(&oracle_counters);
+  oracle_branches = 0;
+  oracle_mispredictions = 0;
+}
+
+inline uint8_t oracle_direction(uint8_t counter)
+{
+  return counter >= WT ? TAKEN : NOTTAKEN;
+}
+
+inline void oracle_update(uint8_t *counter, uint8_t outcome)
+{
+  *counter = outcome ? (*counter < ST ? *counter + 1 : ST) : (*counter > SN ? *counter - 1 : SN);
+}
+
+uint8_t oracle_gshare(uint32_t pc, const bp_context *ctx, uint8_t outcome)
+{
+  uint8_t *bht = oracle_counter(oracle_key(ORACLE_GLOBAL, pc, ctx->ghistory, ghistoryBits), WN, 1);
+  uint8_t prediction = oracle_direction(*bht);
+  oracle_update(bht, outcome);
+  return prediction;
+}
+
+// Same choice rule as the tournament predictor, including training the
+// chooser on the updated component predictions
+//
+uint8_t oracle_tour(uint32_t pc, const bp_context *ctx, uint8_t outcome)
+{
+  uint8_t *gpt = oracle_counter(oracle_key(ORACLE_GLOBAL, pc, ctx->ghistory, tour_ghistoryBits), WN, 1);
+  uint8_t *lpt = oracle_counter(oracle_key(ORACLE_LOCAL, pc, ctx->lhistory, tour_lhistoryBits), WN, 1);
+  uint8_t *cpt = oracle_counter(oracle_key(ORACLE_CHOICE, pc, ctx->ghistory, tour_choiceBits), WL, 1);
+  uint8_t prediction = oracle_direction(*cpt >= WG ? *gpt : *lpt);
+
+  oracle_update(gpt, outcome);
+  oracle_update(lpt, outcome);
+  uint8_t gpt_prediction = oracle_direction(*gpt);
+  if (gpt_prediction != oracle_direction(*lpt))
+  {
+    oracle_update(cpt, outcome == gpt_prediction);
+  }
+  return prediction;
+}
+
+// YAGS with unbounded caches: an exception is cached for every
+// (PC, global history) it was ever allocated for and never evicted
+//
+uint8_t oracle_YAGS(uint32_t pc, const bp_context *ctx, uint8_t outcome)
+{
+  uint8_t *lpt = oracle_counter(oracle_key(ORACLE_LOCAL, pc, ctx->lhistory, YAGS_lhistoryBits), WN, 1);
+  uint8_t lpt_prediction = oracle_direction(*lpt);
+  int cache = (lpt_prediction == TAKEN) ? ORACLE_NTCACHE : ORACLE_TCACHE;
+  uint8_t *hit = oracle_counter(oracle_key(cache, pc, ctx->ghistory, YAGS_ghistoryBits), 0, 0);
+  uint8_t prediction = hit ? oracle_direction(*hit) : lpt_prediction;
+
+  // Training selects the cache with the updated LPT prediction
+  oracle_update(lpt, outcome);
+  lpt_prediction = oracle_direction(*lpt);
+  cache = (lpt_prediction == TAKEN) ? ORACLE_NTCACHE : ORACLE_TCACHE;
+  uint64_t key = oracle_key(cache, pc, ctx->ghistory, YAGS_ghistoryBits);
+  hit = oracle_counter(key, 0, 0);
+  if (hit)
+  {
+    oracle_update(hit, outcome);
+  }
+  else if (outcome != lpt_prediction)
+  {
+    oracle_counter(key, (outcome == TAKEN) ? WT : WN, 1);
+  }
+  return prediction;
+}
+
+void oracle_branch(uint32_t pc, const bp_context *ctx, uint8_t outcome, int measure)
+{
+  uint8_t prediction;
+  switch (bpType)
+  {
+  case GSHARE:
+    prediction = oracle_gshare(pc, ctx, outcome);
+    break;
+  case TOURNAMENT:
+    prediction = oracle_tour(pc, ctx, outcome);
+    break;
+  case CUSTOM:
+    prediction = oracle_YAGS(pc, ctx, outcome);
+    break;
+  default:
+    prediction = TAKEN;
+    break;
+  }
+
+  if (measure)
+  {
+    oracle_branches++;
+    oracle_mispredictions += (prediction != outcome);
+  }
+}
+
+void print_oracle(uint64_t finite_mispredictions)
+{
+  int64_t gap = (int64_t)finite_mispredictions - (int64_t)oracle_mispredictions;
+  size_t bytes = counter_map_bytes(&oracle_counters);
+  printf("Oracle (interference-free):\n");
+  printf("Incorrect:       %10llu\n", (unsigned long long)oracle_mispredictions);
+  printf("Misprediction Rate: %7.3f\n", 1000 * ((float)oracle_mispredictions / (float)oracle_branches));
+  printf("Aliasing gap:    %+10lld (%.2f%% of the finite mispredictions)\n", (long long)gap,
+         finite_mispredictions > 0 ? 100 * ((double)gap / (double)finite_mispredictions) : 0.0);
+  printf("Counters:        %10u (%.1f MiB)\n", oracle_counters.used, bytes / (1024.0 * 1024.0));
+}
+
+void cleanup_oracle()
+{
+  free_counter_map(&oracle_counters);
+}
@@ -0,0 +1,32 @@
+//========================================================//
+//  oracle.h                                              //
+//  Header file for the interference-free oracle          //
+//                                                        //
+//  Shadows the configured predictor with a private       //
+//  counter for every (PC, history) tuple it indexes by   //
+//========================================================//
+
+#ifndef ORACLE_H
+#define ORACLE_H
+
+#include <stdint.h>
+#include "predictor.h"
+
+// Initialize the oracle for the configured predictor type
+//
+void init_oracle();
+
+// Predict and train the oracle on a resolved conditional branch at PC
+// 'pc', using the histories in the context its real prediction was made
+// with. Only branches with 'measure' set are scored.
+//
+void oracle_branch(uint32_t pc, const bp_context *ctx, uint8_t outcome, int measure);
+
+// Print the oracle accuracy and its gap to the 'finite_mispredictions'
+// of the real predictor over the same branches
+//
+void print_oracle(uint64_t finite_mispredictions);
+
+void cleanup_oracle();
+
+#endif
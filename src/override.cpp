@@ -0,0 +1,114 @@
+//========================================================//
+//  override.cpp                                          //
+//  Source file for the overriding predictor model        //
+//                                                        //
+//  Fetch follows the fast prediction; a disagreeing slow //
+//  prediction refetches, costing the override latency    //
+//========================================================//
+#include <stdio.h>
+#include <stdlib.h>
+#include "override.h"
+#include "predictor.h"
+
+//------------------------------------//
+//      Override Configuration        //
+//------------------------------------//
+
+const char *overrideName[3] = {"none", "bimodal", "gshare"};
+
+int overrideType = OVERRIDE_NONE;
+int overrideBits = 10;    // Number of bits used for the fast table index
+int overrideLatency = 2;  // Number of cycles of the slow predictor
+
+//------------------------------------//
+//    Override Data Structures        //
+//------------------------------------//
+
+uint8_t *fast_table;      // (2^overrideBits) * 2 bits
+uint32_t fast_history;    // global history of the fast gshare
+
+// Measured branches by which predictions were correct
+uint64_t both_correct = 0;
+uint64_t useful_overrides = 0;  // fast wrong, slow right
+uint64_t harmful_overrides = 0; // fast right, slow wrong
+uint64_t both_wrong = 0;
+uint64_t override_bubbles = 0;
+
+//------------------------------------//
+//       Override Functions           //
+//------------------------------------//
+
+void init_override()
+{
+  int entries = 1 << overrideBits;
+  fast_table = (uint8_t *)malloc(entries * sizeof(uint8_t));
+  for (int i = 0; i < entries; i++)
+  {
+    fast_table[i] = WN;
+  }
+  fast_history = 0;
+}
+
+uint32_t fast_index(uint32_t pc)
+{
+  uint32_t index = (overrideType == OVERRIDE_GSHARE) ? pc ^ fast_history : pc;
+  return index & ((1 << overrideBits) - 1);
+}
+
+uint8_t override_predict(uint32_t pc, uint32_t *index)
+{
+  *index = fast_index(pc);
+  return (fast_table[*index] >= WT) ? TAKEN : NOTTAKEN;
+}
+
+void override_train(uint32_t index, uint8_t outcome)
+{
+  uint8_t *counter = &fast_table[index];
+  if (outcome == TAKEN && *counter < ST)
+    (*counter)++;
+  else if (outcome == NOTTAKEN && *counter > SN)
+    (*counter)--;
+  fast_history = (fast_history << 1) | outcome;
+}
+
+int account_override(uint8_t fast, uint8_t slow, uint8_t outcome, int measure)
+{
+  int bubbles = (fast != slow) ? overrideLatency : 0;
+  if (measure)
+  {
+    if (fast == slow)
+    {
+      both_correct += (slow == outcome);
+      both_wrong += (slow != outcome);
+    }
+    else
+    {
+      useful_overrides += (slow == outcome);
+      harmful_overrides += (fast == outcome);
+    }
+    override_bubbles += bubbles;
+  }
+  return bubbles;
+}
+
+void print_override_stats()
+{
+  uint64_t branches = both_correct + useful_overrides + harmful_overrides + both_wrong;
+  uint64_t overrides = useful_overrides + harmful_overrides;
+  uint64_t fast_incorrect = useful_overrides + both_wrong;
+  printf("Overriding:      %s:%d fast predictor, %d cycle override\n", overrideName[overrideType],
+         overrideBits, overrideLatency);
+  printf("Fast incorrect:  %10llu\n", (unsigned long long)fast_incorrect);
+  printf("Fast rate:          %7.3f\n", 1000 * ((float)fast_incorrect / (float)branches));
+  printf("Final incorrect: %10llu\n", (unsigned long long)(harmful_overrides + both_wrong));
+  printf("Overrides:       %10llu (%.3f per 1000 branches)\n", (unsigned long long)overrides,
+         1000 * ((float)overrides / (float)branches));
+  printf("  Useful:        %10llu\n", (unsigned long long)useful_overrides);
+  printf("  Harmful:       %10llu\n", (unsigned long long)harmful_overrides);
+  printf("Bubbles:         %10llu cycles\n", (unsigned long long)override_bubbles);
+}
+
+void cleanup_override()
+{
+  free(fast_table);
+}
@@ -0,0 +1,45 @@
+//========================================================//
+//  override.h                                            //
+//  Header file for the overriding predictor model        //
+//                                                        //
+//  A small single-cycle predictor answers first and the  //
+//  configured predictor overrides it a few cycles later  //
+//========================================================//
+
+#ifndef OVERRIDE_H
+#define OVERRIDE_H
+
+#include <stdint.h>
+
+// The Different Fast Predictors
+#define OVERRIDE_NONE 0
+#define OVERRIDE_BIMODAL 1 // 2-bit counters indexed by PC
+#define OVERRIDE_GSHARE 2  // 2-bit counters indexed by PC xor global history
+extern const char *overrideName[];
+
+extern int overrideType;
+extern int overrideBits;    // log2 of the fast predictor entries
+extern int overrideLatency; // cycles until the slow prediction is known
+
+// Initialize the fast predictor
+//
+void init_override();
+
+// Fast prediction for the conditional branch at PC 'pc', setting 'index'
+// to the entry it read, and the training of that entry once the branch
+// has resolved
+//
+uint8_t override_predict(uint32_t pc, uint32_t *index);
+void override_train(uint32_t index, uint8_t outcome);
+
+// Account a resolved branch whose fast prediction was 'fast' and whose
+// slow prediction, the one that stands, was 'slow'
+//
+// Returns the bubble cycles of the override, 0 when there was none
+//
+int account_override(uint8_t fast, uint8_t slow, uint8_t outcome, int measure);
+
+void print_override_stats();
+void cleanup_override();
+
+#endif
@@ -7,7 +7,11 @@
 //========================================================//
 #include <stdio.h>
 #include <math.h>
+#include <string.h>
+#include <stddef.h>
 #include "predictor.h"
+#include "alias.h"
+#include "access.h"
 
 //
 // TODO:Student Information
@@ -21,26 +25,35 @@ const char *email = "yuy088@ucsd.edu";
 //------------------------------------//
 
 // Handy Global for use in output routines
-const char *bpName[4] = {"Static", "Gshare", "Tournament", "Custom"};
+const char *bpName[5] = {"Static", "Gshare", "Tournament", "Custom", "Hybrid"};
 
 // define number of bits required for indexing the BHT here.
 int ghistoryBits = 17; // Number of bits used for Global History
 int bpType;            // Branch Prediction Type
 int verbose;
+int spec_history;      // Update histories at prediction time
+
+// The storage of every configuration is computed from these sizes by
+// declare_tables(); run with any predictor to see the breakdown.
 
 // --------------- Tournament ---------------
-int tour_choiceBits   = 14; // Number of bits used for Choice Table    -> Choice Prediction Table has 2^12 entries
-int tour_ghistoryBits = 16; // Number of bits used for Global History  -> Global Prediction Table has 2^12 entries
-int tour_lhistoryBits = 14; // Number of bits used for Local  History  -> Local  Prediction Table has 2^10 entries
-int tour_pcBits = 10;       // Number of bits used for program counter -> Local  History    Table : (2^tour_pcBits) * tour_lhistoryBits = (2^10, 10)
+int tour_choiceBits   = 14; // Number of bits used for Choice Table    -> Choice Prediction Table has 2^tour_choiceBits entries
+int tour_ghistoryBits = 16; // Number of bits used for Global History  -> Global Prediction Table has 2^tour_ghistoryBits entries
+int tour_lhistoryBits = 14; // Number of bits used for Local  History  -> Local  Prediction Table has 2^tour_lhistoryBits entries
+int tour_pcBits = 10;       // Number of bits used for program counter -> Local  History    Table has 2^tour_pcBits entries
 
 // --------------- YAGS with 2-level local pattern table ---------------
-// index bits = log2(# entries/2) = YAGS_cacheBits - 1 
-// tag_bits = YAGS_ghistoryBits - index bits = YAGS_ghistoryBits - YAGS_cacheBits + 1 = 16 - 12 + 1 = 5
-int YAGS_cacheBits = 14;    // Number of bits used for Cache entries   -> Cache Table: (2^YAGS_cacheBits) * (valid_bit + LRU_bit + counter_bit + tag_bit ) = (2^12) * (1+1+2+5)
+// set index bits = log2(# entries / 2 ways) = YAGS_cacheBits - 1
+// tag bits = YAGS_ghistoryBits - set index bits = 16 - 13 = 3
+int YAGS_cacheBits = 14;    // Number of bits used for Cache entries   -> each Cache has 2^YAGS_cacheBits entries of tag + 2-bit counter
 int YAGS_ghistoryBits = 16; // Number of bits used for Global History 
-int YAGS_lhistoryBits = 15; // Number of bits used for Local  History  -> Local  Prediction Table: (2^YAGS_lhistoryBits) * 2 = (2^12, 2)
-int YAGS_pcBits = 10;       // Number of bits used for program counter -> Local  History    Table: (2^tour_pcBits) * tour_lhistoryBits = (2^10, 12)
+int YAGS_lhistoryBits = 15; // Number of bits used for Local  History  -> Local  Prediction Table has 2^YAGS_lhistoryBits entries
+int YAGS_pcBits = 10;       // Number of bits used for program counter -> Local  History    Table has 2^YAGS_pcBits entries
+
+// --------------- N-way hybrid ---------------
+// gshare and local components picked by usefulness counters indexed
+// with the global history
+hybrid_config hybrid_cfg = {2, {{COMP_GSHARE, 15}, {COMP_LOCAL, 11}}, CHOOSE_TABLES, INDEX_HIST, 12, 10};
 
 //------------------------------------//
 //      Predictor Data Structures     //
@@ -55,24 +68,30 @@ uint64_t ghistory;
 uint8_t *bht_gshare;
 
 // --------------- tournament ---------------
-uint8_t *gpt_tour;  // Global Prediction Table (2^tour_ghistoryBits) * 2 = (2^14, 2)
-uint8_t *cpt_tour;  // Choice Prediction Table (2^tour_ghistoryBits) * 2 = (2^16, 2)
-uint8_t *lpt_tour;  // Local  Prediction Table (2^tour_lhistoryBits) * 2 = (2^14, 2)
-uint16_t *lht_tour; // Local  History    Table (2^tour_pcBits) * tour_lhistoryBits = (2^10, 14)
+uint8_t *gpt_tour;  // Global Prediction Table (2^tour_ghistoryBits) * 2
+uint8_t *cpt_tour;  // Choice Prediction Table (2^tour_choiceBits) * 2
+uint8_t *lpt_tour;  // Local  Prediction Table (2^tour_lhistoryBits) * 2
+uint16_t *lht_tour; // Local  History    Table (2^tour_pcBits) * tour_lhistoryBits
 
 
 // --------------- YAGS with 2-level local pattern table ---------------
-uint8_t *lpt_YAGS;      // Local  Prediction Table: (2^YAGS_lhistoryBits) * 2 = (2^12, 2)
-uint16_t *lht_YAGS;     // Local  History    Table: (2^YAGS_pcBits) * YAGS_lhistoryBits = (2^10, 12)
-// Take Cache:     (2^YAGS_cacheBits) * ( YAGS_lhistoryBits + 2) = (2^12, 1+1+2+5)
-// Not Take Cache: (2^YAGS_cacheBits) * ( YAGS_lhistoryBits + 2) = (2^12, 1+1+2+5)
-uint16_t *TCache_tag_YAGS;     // (2^YAGS_cacheBits)     * 5 bits
+uint8_t *lpt_YAGS;      // Local  Prediction Table: (2^YAGS_lhistoryBits) * 2
+uint16_t *lht_YAGS;     // Local  History    Table: (2^YAGS_pcBits) * YAGS_lhistoryBits
+// Take Cache:     (2^YAGS_cacheBits) * (tag bits + 2), 2-way with one LRU bit per set
+// Not Take Cache: (2^YAGS_cacheBits) * (tag bits + 2), 2-way with one LRU bit per set
+uint16_t *TCache_tag_YAGS;     // (2^YAGS_cacheBits)     * tag bits
 uint8_t  *TCache_counter_YAGS; // (2^YAGS_cacheBits)     * 2 bits
-uint8_t  *TCache_LRU_YAGS;     // (2^YAGS_cacheBits - 1) * 1 bit
+uint8_t  *TCache_LRU_YAGS;     // (2^(YAGS_cacheBits-1)) * 1 bit
 
-uint16_t *NTCache_tag_YAGS;     // (2^YAGS_cacheBits)     * 5 bits
+uint16_t *NTCache_tag_YAGS;     // (2^YAGS_cacheBits)     * tag bits
 uint8_t  *NTCache_counter_YAGS; // (2^YAGS_cacheBits)     * 2 bits
-uint8_t  *NTCache_LRU_YAGS;     // (2^YAGS_cacheBits - 1) * 1 bit
+uint8_t  *NTCache_LRU_YAGS;     // (2^(YAGS_cacheBits-1)) * 1 bit
+
+// --------------- N-way hybrid ---------------
+uint8_t *comp_hybrid[MAX_HYBRID_COMPONENTS]; // (2^bits) * 2 per component
+uint16_t *lht_hybrid;     // Local History Table: (2^pcBits) * longest local history
+int8_t *chooser_hybrid;   // (2^chooserBits) * (components + 1) chooser fields
+int hybrid_lhistoryBits;  // longest local history of the components
 
 
 //------------------------------------//
@@ -95,13 +114,22 @@ void init_gshare()
   ghistory = 0;
 }
 
-uint8_t gshare_predict(uint32_t pc)
+// Compute the BHT index for the branch at PC 'pc' from the histories
+// in 'ctx'
+//
+void gshare_locate(uint32_t pc, bp_context *ctx)
 {
   // get lower ghistoryBits of pc
   uint32_t bht_entries = 1 << ghistoryBits;
   uint32_t pc_lower_bits = pc & (bht_entries - 1);
-  uint32_t ghistory_lower_bits = ghistory & (bht_entries - 1);
-  uint32_t index = pc_lower_bits ^ ghistory_lower_bits;
+  uint32_t ghistory_lower_bits = ctx->ghistory & (bht_entries - 1);
+  ctx->gshare.index = pc_lower_bits ^ ghistory_lower_bits;
+}
+
+uint8_t gshare_predict(bp_context *ctx)
+{
+  uint32_t index = ctx->gshare.index;
+  ctx->counter = bht_gshare[index];
   switch (bht_gshare[index])
   {
   case WN:
@@ -118,13 +146,9 @@ uint8_t gshare_predict(uint32_t pc)
   }
 }
 
-void train_gshare(uint32_t pc, uint8_t outcome)
+void train_gshare(uint8_t outcome, const bp_context *ctx)
 {
-  // get lower ghistoryBits of pc
-  uint32_t bht_entries = 1 << ghistoryBits;
-  uint32_t pc_lower_bits = pc & (bht_entries - 1);
-  uint32_t ghistory_lower_bits = ghistory & (bht_entries - 1);
-  uint32_t index = pc_lower_bits ^ ghistory_lower_bits;
+  uint32_t index = ctx->gshare.index;
 
   // Update state of entry in bht based on outcome
   switch (bht_gshare[index])
@@ -146,8 +170,6 @@ void train_gshare(uint32_t pc, uint8_t outcome)
     break;
   }
 
-  // Update history register
-  ghistory = ((ghistory << 1) | outcome);
 }
 
 void cleanup_gshare()
@@ -206,7 +228,7 @@ void init_tour()
   gpt_tour = (uint8_t *)malloc(gpt_entries * sizeof(uint8_t));
   cpt_tour = (uint8_t *)malloc(cpt_entries * sizeof(uint8_t));
   lpt_tour = (uint8_t *)malloc(lpt_entries * sizeof(uint8_t));
-  lht_tour = (uint16_t *)malloc(lpt_entries * sizeof(uint16_t));
+  lht_tour = (uint16_t *)malloc(lht_entries * sizeof(uint16_t));
 
   int i = 0;
   for (i = 0; i < gpt_entries; i++) { gpt_tour[i] = WN; }
@@ -217,30 +239,36 @@ void init_tour()
   ghistory = 0;
 }
 
-uint8_t tour_predict(uint32_t pc)
+// Compute the GPT, CPT and LPT indices from the histories in 'ctx'
+//
+void tour_locate(bp_context *ctx)
 {
   // get lower tour_ghistoryBits of ghistory
   uint32_t gpt_entries = 1 << tour_ghistoryBits;
-  uint32_t gpt_index = ghistory & (gpt_entries - 1); // ghistory_lower_bits
+  ctx->tour.gpt_index = ctx->ghistory & (gpt_entries - 1); // ghistory_lower_bits
 
   uint32_t cpt_entries = 1 << tour_choiceBits;
-  uint32_t cpt_index = ghistory & (cpt_entries - 1); // ghistory_lower_bits
-
-  uint32_t lht_entries = 1 << tour_pcBits;
-  uint32_t lht_index = pc & (lht_entries - 1); // pc_lower_bits
+  ctx->tour.cpt_index = ctx->ghistory & (cpt_entries - 1); // ghistory_lower_bits
 
   uint32_t lpt_entries = 1 << tour_lhistoryBits;
-  uint32_t lpt_index = lht_tour[lht_index] & (lpt_entries-1);
+  ctx->tour.lpt_index = ctx->lhistory & (lpt_entries-1);
+}
+
+uint8_t tour_predict(bp_context *ctx)
+{
+  uint32_t gpt_index = ctx->tour.gpt_index;
+  uint32_t cpt_index = ctx->tour.cpt_index;
+  uint32_t lpt_index = ctx->tour.lpt_index;
 
   switch(cpt_tour[cpt_index])
   {
     case SL:
-      return getPrediction(lpt_tour[lpt_index]);
     case WL:
+      ctx->counter = lpt_tour[lpt_index];
       return getPrediction(lpt_tour[lpt_index]);
     case WG:
-      return getPrediction(gpt_tour[gpt_index]);
     case SG:
+      ctx->counter = gpt_tour[gpt_index];
       return getPrediction(gpt_tour[gpt_index]);  
     default:
       printf("Warning: Undefined state of entry in Tournament CPT!\n");
@@ -248,20 +276,11 @@ uint8_t tour_predict(uint32_t pc)
   }
 }
 
-void train_tour(uint32_t pc, uint8_t outcome)
+void train_tour(uint8_t outcome, const bp_context *ctx)
 {
-  // get lower tour_ghistoryBits of ghistory
-  uint32_t gpt_entries = 1 << tour_ghistoryBits;
-  uint32_t gpt_index = ghistory & (gpt_entries - 1); // ghistory_lower_bits
-
-  uint32_t cpt_entries = 1 << tour_choiceBits;
-  uint32_t cpt_index = ghistory & (cpt_entries - 1); // ghistory_lower_bits
-
-  uint32_t lht_entries = 1 << tour_pcBits;
-  uint32_t lht_index = pc & (lht_entries - 1); // pc_lower_bits
-
-  uint32_t lpt_entries = 1 << tour_lhistoryBits;
-  uint32_t lpt_index = lht_tour[lht_index] & (lpt_entries-1);
+  uint32_t gpt_index = ctx->tour.gpt_index;
+  uint32_t cpt_index = ctx->tour.cpt_index;
+  uint32_t lpt_index = ctx->tour.lpt_index;
 
   // Update state of entry in gpt based on outcome
   updatePredictionTableState(gpt_tour[gpt_index], outcome);
@@ -293,14 +312,6 @@ void train_tour(uint32_t pc, uint8_t outcome)
         break;
     }
   }
-
-
-  // Update history register
-  ghistory = ((ghistory << 1) | outcome);
-
-  // Update state of entry in lht (local history table)
-  lht_tour[lht_index] = ( (lht_tour[lht_index] << 1)   | outcome);
-
 }
 
 void cleanup_tour()
@@ -350,27 +361,35 @@ void init_YAGS()
   ghistory = 0;
 }
 
-uint8_t YAGS_predict(uint32_t pc)
+// Compute the LPT index and the cache set and tag for the branch at PC
+// 'pc' from the histories in 'ctx'
+//
+void YAGS_locate(uint32_t pc, bp_context *ctx)
 {
-  uint32_t lht_entries = 1 << YAGS_pcBits;
-  uint32_t lht_index = pc & (lht_entries - 1); // pc_lower_bits
-
   uint32_t lpt_entries = 1 << YAGS_lhistoryBits;
-  uint32_t lpt_index = lht_YAGS[lht_index] & (lpt_entries-1); // lower bits of lht_YAGS[lht_index]
+  ctx->yags.lpt_index = ctx->lhistory & (lpt_entries-1); // lower bits of the local history
 
   // get lower ghistoryBits of pc
   uint32_t cache_entries = 1 << YAGS_ghistoryBits;
   uint32_t pc_lower_bits = pc & (cache_entries - 1);
-  uint32_t ghistory_lower_bits = ghistory & (cache_entries - 1);
+  uint32_t ghistory_lower_bits = ctx->ghistory & (cache_entries - 1);
   uint32_t cache_index = pc_lower_bits ^ ghistory_lower_bits; // bit_num: YAGS_ghistoryBits = 16
 
-  int set_index_bits = YAGS_cacheBits-1; // 12 - 1 = 11 bits
+  int set_index_bits = YAGS_cacheBits-1; // 14 - 1 = 13 bits
   uint32_t set_entries = 1 << set_index_bits; 
-  uint32_t set_index = cache_index & (set_entries-1); // take LSB for 11 bits
+  ctx->yags.set_index = cache_index & (set_entries-1); // take LSB for 13 bits
+
+  ctx->yags.tag = (cache_index >> set_index_bits); // 16 - 13 = 3 bits
+}
 
-  uint16_t tag = (cache_index >> set_index_bits); // 16 - 11 = 5 bits
+uint8_t YAGS_predict(bp_context *ctx)
+{
+  uint32_t lpt_index = ctx->yags.lpt_index;
+  uint32_t set_index = ctx->yags.set_index;
+  uint16_t tag = ctx->yags.tag;
 
   uint8_t  lpt_prediction = getPrediction(lpt_YAGS[lpt_index]);
+  ctx->counter = lpt_YAGS[lpt_index];
 
   // pre-initiation
   uint16_t tag_0 = 0,     tag_1 = 0;
@@ -385,8 +404,8 @@ uint8_t YAGS_predict(uint32_t pc)
       counter_0 =  NTCache_counter_YAGS[ (set_index << 1)     ];
       counter_1 =  NTCache_counter_YAGS[ (set_index << 1) + 1 ];
        
-      if (tag == tag_0){       return getPrediction(counter_0); }
-      else if (tag == tag_1){  return getPrediction(counter_1);}
+      if (tag == tag_0){       ctx->counter = counter_0; return getPrediction(counter_0); }
+      else if (tag == tag_1){  ctx->counter = counter_1; return getPrediction(counter_1);}
       else {                              return lpt_prediction;}
 
     case NOTTAKEN: // check T Cache
@@ -396,8 +415,8 @@ uint8_t YAGS_predict(uint32_t pc)
       counter_0 =  TCache_counter_YAGS[ (set_index << 1)     ];
       counter_1 =  TCache_counter_YAGS[ (set_index << 1) + 1 ];
        
-      if (tag == tag_0){       return getPrediction(counter_0); }
-      else if (tag == tag_1){  return getPrediction(counter_1);}
+      if (tag == tag_0){       ctx->counter = counter_0; return getPrediction(counter_0); }
+      else if (tag == tag_1){  ctx->counter = counter_1; return getPrediction(counter_1);}
       else {                              return lpt_prediction;}
 
     default:
@@ -406,29 +425,15 @@ uint8_t YAGS_predict(uint32_t pc)
   }
 }
 
-void train_YAGS(uint32_t pc, uint8_t outcome)
+void train_YAGS(uint8_t outcome, const bp_context *ctx)
 {
-  uint32_t lht_entries = 1 << YAGS_pcBits;
-  uint32_t lht_index = pc & (lht_entries - 1); // pc_lower_bits
-
-  uint32_t lpt_entries = 1 << YAGS_lhistoryBits;
-  uint32_t lpt_index = lht_YAGS[lht_index] & (lpt_entries-1);
+  uint32_t lpt_index = ctx->yags.lpt_index;
+  uint32_t set_index = ctx->yags.set_index;
+  uint16_t tag = ctx->yags.tag;
 
   // Update state of entry in lpt based on outcome
   updatePredictionTableState(lpt_YAGS[lpt_index], outcome);
 
-
-  // get lower ghistoryBits of pc
-  uint32_t cache_entries = 1 << YAGS_ghistoryBits;
-  uint32_t pc_lower_bits = pc & (cache_entries - 1);
-  uint32_t ghistory_lower_bits = ghistory & (cache_entries - 1);
-  uint32_t cache_index = pc_lower_bits ^ ghistory_lower_bits; // bit_num: YAGS_ghistoryBits = 16
-
-  int set_index_bits = YAGS_cacheBits-1; // 12 - 1 = 11 bits
-  uint32_t set_entries = 1 << set_index_bits; 
-  uint32_t set_index = cache_index & (set_entries-1); // take LSB for 11 bits
-
-  uint16_t tag = (cache_index >> set_index_bits); // 16 - 11 = 5 bits
   uint8_t lpt_prediction = getPrediction(lpt_YAGS[lpt_index]);
 
   // pre-initiation
@@ -527,16 +532,6 @@ void train_YAGS(uint32_t pc, uint8_t outcome)
     break;
   }
 
-
-
-
-  // Update history register
-  ghistory = ((ghistory << 1) | outcome);
-
-  // Update state of entry in lht (local history table)
-  lht_YAGS[lht_index] = ( (lht_YAGS[lht_index] << 1)   | outcome);
-
-
 }
 
 void cleanup_YAGS()
@@ -553,78 +548,1663 @@ void cleanup_YAGS()
   free(NTCache_LRU_YAGS);
 }
 
-// ============================================================
+#ifdef BP_ALIAS_STATS
+// --------------- Aliasing analysis ---------------
+// Every access is classified when the branch trains, against the state
+// the entry has right before the update
 
-void init_predictor()
+int alias_bht_gshare;
+int alias_gpt_tour, alias_cpt_tour, alias_lpt_tour;
+int alias_lpt_YAGS, alias_TCache_YAGS, alias_NTCache_YAGS;
+
+void register_alias_tables()
 {
   switch (bpType)
   {
-  case STATIC:
-    break;
   case GSHARE:
-    init_gshare();
+    alias_bht_gshare = register_alias_table("bht_gshare", 1 << ghistoryBits);
     break;
   case TOURNAMENT:
-    init_tour();
+    alias_gpt_tour = register_alias_table("gpt_tour", 1 << tour_ghistoryBits);
+    alias_cpt_tour = register_alias_table("cpt_tour", 1 << tour_choiceBits);
+    alias_lpt_tour = register_alias_table("lpt_tour", 1 << tour_lhistoryBits);
     break;
   case CUSTOM:
-    init_YAGS();
+    alias_lpt_YAGS = register_alias_table("lpt_YAGS", 1 << YAGS_lhistoryBits);
+    alias_TCache_YAGS = register_alias_table("TCache_YAGS", 1 << YAGS_cacheBits);
+    alias_NTCache_YAGS = register_alias_table("NTCache_YAGS", 1 << YAGS_cacheBits);
     break;
   default:
     break;
   }
 }
 
-// Make a prediction for conditional branch instruction at PC 'pc'
-// Returning TAKEN indicates a prediction of taken; returning NOTTAKEN
-// indicates a prediction of not taken
+// Classify an access to a direction counter in state 'state' and train
+// the private counter of the branch
 //
-uint32_t make_prediction(uint32_t pc, uint32_t target, uint32_t direct)
+void alias_counter(int table, uint32_t index, uint32_t pc, uint8_t state, uint8_t init,
+                   uint8_t outcome, uint8_t mispredicted)
 {
+  uint8_t *own = alias_private(table, index, pc, init);
+  alias_access(table, index, pc, getPrediction(state) == outcome, getPrediction(*own) == outcome,
+               mispredicted);
+  updatePredictionTableState(*own, outcome);
+}
 
-  // Make a prediction based on the bpType
+// A choice is correct when the component it picks is; the private
+// chooser trains like the shared one
+//
+void alias_choice(int table, uint32_t index, uint32_t pc, uint8_t state, uint8_t gpt_prediction,
+                  uint8_t lpt_prediction, uint8_t outcome, uint8_t mispredicted)
+{
+  uint8_t *own = alias_private(table, index, pc, WL);
+  uint8_t shared_choice = (state >= WG) ? gpt_prediction : lpt_prediction;
+  uint8_t own_choice = (*own >= WG) ? gpt_prediction : lpt_prediction;
+  alias_access(table, index, pc, shared_choice == outcome, own_choice == outcome, mispredicted);
+  if (gpt_prediction != lpt_prediction)
+  {
+    updatePredictionTableState(*own, outcome == gpt_prediction);
+  }
+}
+
+void alias_record(uint32_t pc, uint8_t outcome, const bp_context *ctx)
+{
+  uint8_t mispredicted = (ctx->prediction != outcome);
+  uint32_t index;
   switch (bpType)
   {
-  case STATIC:
-    return TAKEN;
   case GSHARE:
-    return gshare_predict(pc);
+    index = ctx->gshare.index;
+    alias_counter(alias_bht_gshare, index, pc, bht_gshare[index], WN, outcome, mispredicted);
+    break;
   case TOURNAMENT:
-    return tour_predict(pc);
+    alias_counter(alias_gpt_tour, ctx->tour.gpt_index, pc, gpt_tour[ctx->tour.gpt_index], WN,
+                  outcome, mispredicted);
+    alias_counter(alias_lpt_tour, ctx->tour.lpt_index, pc, lpt_tour[ctx->tour.lpt_index], WN,
+                  outcome, mispredicted);
+    alias_choice(alias_cpt_tour, ctx->tour.cpt_index, pc, cpt_tour[ctx->tour.cpt_index],
+                 getPrediction(gpt_tour[ctx->tour.gpt_index]),
+                 getPrediction(lpt_tour[ctx->tour.lpt_index]), outcome, mispredicted);
+    break;
   case CUSTOM:
-    return YAGS_predict(pc);
+  {
+    uint8_t lpt_state = lpt_YAGS[ctx->yags.lpt_index];
+    alias_counter(alias_lpt_YAGS, ctx->yags.lpt_index, pc, lpt_state, WN, outcome, mispredicted);
+
+    // Only a hit reads a cache entry; the private counter of a branch
+    // starts from the entry it first hits
+    int table = (getPrediction(lpt_state) == TAKEN) ? alias_NTCache_YAGS : alias_TCache_YAGS;
+    uint16_t *tags = (table == alias_NTCache_YAGS) ? NTCache_tag_YAGS : TCache_tag_YAGS;
+    uint8_t *counters = (table == alias_NTCache_YAGS) ? NTCache_counter_YAGS : TCache_counter_YAGS;
+    index = ctx->yags.set_index << 1;
+    if (tags[index] != ctx->yags.tag)
+      index++;
+    if (tags[index] == ctx->yags.tag)
+    {
+      alias_counter(table, index, pc, counters[index], counters[index], outcome, mispredicted);
+    }
+    break;
+  }
   default:
     break;
   }
-
-  // If there is not a compatable bpType then return NOTTAKEN
-  return NOTTAKEN;
 }
+#endif
 
-// Train the predictor the last executed branch at PC 'pc' and with
-// outcome 'outcome' (true indicates that the branch was taken, false
-// indicates that the branch was not taken)
+// --------------- N-way hybrid ---------------
+// Any mix of bimodal, global, gshare and local components. Each chooser
+// entry holds one field per component plus one spare (the perceptron
+// bias): 2-bit usefulness counters that pick the most useful component,
+// 3-bit vote weights, or signed 8-bit perceptron weights.
+
+const char *compName[4] = {"bimodal", "global", "gshare", "local"};
+const char *chooseName[3] = {"tables", "vote", "perceptron"};
+const char *indexName[3] = {"pc", "hist", "pcxhist"};
+
+#define VOTE_MAX 7
+#define WEIGHT_MAX 127
+#define WEIGHT_MIN -128
+
+// Counters start weakly useless, votes at half weight
 //
+int8_t hybrid_chooser_init()
+{
+  return (hybrid_cfg.chooser == CHOOSE_TABLES) ? 1 : (hybrid_cfg.chooser == CHOOSE_VOTE) ? 4 : 0;
+}
 
-void train_predictor(uint32_t pc, uint32_t target, uint32_t outcome, uint32_t condition, uint32_t call, uint32_t ret, uint32_t direct)
+void init_hybrid()
 {
-  if (condition)
+  int n = hybrid_cfg.num_components;
+  hybrid_lhistoryBits = 0;
+  for (int c = 0; c < n; c++)
   {
-    switch (bpType)
+    int entries = 1 << hybrid_cfg.components[c].bits;
+    comp_hybrid[c] = (uint8_t *)malloc(entries * sizeof(uint8_t));
+    for (int i = 0; i < entries; i++) { comp_hybrid[c][i] = WN; }
+    if (hybrid_cfg.components[c].kind == COMP_LOCAL && hybrid_cfg.components[c].bits > hybrid_lhistoryBits)
+      hybrid_lhistoryBits = hybrid_cfg.components[c].bits;
+  }
+
+  int lht_entries = 1 << hybrid_cfg.pcBits;
+  lht_hybrid = (uint16_t *)malloc(lht_entries * sizeof(uint16_t));
+  for (int i = 0; i < lht_entries; i++) { lht_hybrid[i] = 0; }
+
+  int fields = (1 << hybrid_cfg.chooserBits) * (n + 1);
+  int8_t init = hybrid_chooser_init();
+  chooser_hybrid = (int8_t *)malloc(fields * sizeof(int8_t));
+  for (int i = 0; i < fields; i++) { chooser_hybrid[i] = init; }
+
+  ghistory = 0;
+}
+
+// Compute the component and chooser entries for the branch at PC 'pc'
+// from the histories in 'ctx'
+//
+void hybrid_locate(uint32_t pc, bp_context *ctx)
+{
+  for (int c = 0; c < hybrid_cfg.num_components; c++)
+  {
+    uint32_t mask = (1u << hybrid_cfg.components[c].bits) - 1;
+    switch (hybrid_cfg.components[c].kind)
     {
-    case STATIC:
-      return;
-    case GSHARE:
-      train_gshare(pc, outcome);
-      return;
-    case TOURNAMENT:
-      train_tour(pc, outcome);
-      return;
-    case CUSTOM:
-      train_YAGS(pc, outcome);
-      return;
+    case COMP_BIMODAL:
+      ctx->hybrid.index[c] = pc & mask;
+      break;
+    case COMP_GLOBAL:
+      ctx->hybrid.index[c] = ctx->ghistory & mask;
+      break;
+    case COMP_GSHARE:
+      ctx->hybrid.index[c] = (pc ^ ctx->ghistory) & mask;
+      break;
     default:
+      ctx->hybrid.index[c] = ctx->lhistory & mask;
       break;
     }
   }
+
+  uint32_t mask = (1u << hybrid_cfg.chooserBits) - 1;
+  switch (hybrid_cfg.index)
+  {
+  case INDEX_PC:
+    ctx->hybrid.chooser_index = pc & mask;
+    break;
+  case INDEX_HIST:
+    ctx->hybrid.chooser_index = ctx->ghistory & mask;
+    break;
+  default:
+    ctx->hybrid.chooser_index = (pc ^ ctx->ghistory) & mask;
+    break;
+  }
+}
+
+int8_t *hybrid_fields(const bp_context *ctx)
+{
+  return &chooser_hybrid[ctx->hybrid.chooser_index * (hybrid_cfg.num_components + 1)];
+}
+
+// Weighted sum of the component predictions, taken counting positive
+//
+int hybrid_sum(const bp_context *ctx)
+{
+  int n = hybrid_cfg.num_components;
+  int8_t *w = hybrid_fields(ctx);
+  int y = (hybrid_cfg.chooser == CHOOSE_PERCEPTRON) ? w[n] : 0;
+  for (int c = 0; c < n; c++)
+  {
+    y += ((ctx->hybrid.predictions >> c) & 1) ? w[c] : -w[c];
+  }
+  return y;
+}
+
+// Direction of a vote or perceptron sum. Tied votes follow the first
+// component.
+//
+uint8_t hybrid_direction(const bp_context *ctx, int y)
+{
+  if (hybrid_cfg.chooser == CHOOSE_PERCEPTRON)
+    return (y >= 0) ? TAKEN : NOTTAKEN;
+  return (y > 0) ? TAKEN : (y < 0) ? NOTTAKEN : (ctx->hybrid.predictions & 1);
+}
+
+uint8_t hybrid_predict(bp_context *ctx)
+{
+  int n = hybrid_cfg.num_components;
+  ctx->hybrid.predictions = 0;
+  for (int c = 0; c < n; c++)
+  {
+    ctx->hybrid.predictions |= getPrediction(comp_hybrid[c][ctx->hybrid.index[c]]) << c;
+  }
+
+  if (hybrid_cfg.chooser == CHOOSE_TABLES)
+  {
+    int8_t *useful = hybrid_fields(ctx);
+    int best = 0;
+    for (int c = 1; c < n; c++)
+    {
+      if (useful[c] > useful[best])
+        best = c;
+    }
+    ctx->counter = comp_hybrid[best][ctx->hybrid.index[best]];
+    return getPrediction(ctx->counter);
+  }
+
+  // A combined prediction only counts as strong when all components agree
+  uint8_t prediction = hybrid_direction(ctx, hybrid_sum(ctx));
+  uint8_t all = (1 << n) - 1;
+  int agree = ctx->hybrid.predictions == 0 || ctx->hybrid.predictions == all;
+  ctx->counter = (prediction == TAKEN) ? (agree ? ST : WT) : (agree ? SN : WN);
+  return prediction;
+}
+
+inline int8_t saturate(int value, int min, int max)
+{
+  return (int8_t)(value < min ? min : value > max ? max : value);
+}
+
+// The chooser learns from the component predictions the branch was
+// predicted with, and only where the components disagree; a perceptron
+// trains on a misprediction or when the sum is within the threshold
+//
+int hybrid_trains_chooser(uint8_t outcome, const bp_context *ctx)
+{
+  int n = hybrid_cfg.num_components;
+  if (hybrid_cfg.chooser == CHOOSE_PERCEPTRON)
+  {
+    int y = hybrid_sum(ctx);
+    int theta = (int)(1.93 * n + 14);
+    return hybrid_direction(ctx, y) != outcome || abs(y) <= theta;
+  }
+  uint8_t all = (1 << n) - 1;
+  return ctx->hybrid.predictions != 0 && ctx->hybrid.predictions != all;
+}
+
+void train_hybrid(uint8_t outcome, const bp_context *ctx)
+{
+  int n = hybrid_cfg.num_components;
+  int8_t *fields = hybrid_fields(ctx);
+  int trains = hybrid_trains_chooser(outcome, ctx);
+
+  switch (hybrid_cfg.chooser)
+  {
+  case CHOOSE_TABLES:
+  case CHOOSE_VOTE:
+  {
+    int max = (hybrid_cfg.chooser == CHOOSE_TABLES) ? ST : VOTE_MAX;
+    for (int c = 0; trains && c < n; c++)
+    {
+      int correct = ((ctx->hybrid.predictions >> c) & 1) == outcome;
+      fields[c] = saturate(fields[c] + (correct ? 1 : -1), 0, max);
+    }
+    break;
+  }
+  case CHOOSE_PERCEPTRON:
+  {
+    if (trains)
+    {
+      int t = (outcome == TAKEN) ? 1 : -1;
+      for (int c = 0; c < n; c++)
+      {
+        int x = ((ctx->hybrid.predictions >> c) & 1) ? 1 : -1;
+        fields[c] = saturate(fields[c] + t * x, WEIGHT_MIN, WEIGHT_MAX);
+      }
+      fields[n] = saturate(fields[n] + t, WEIGHT_MIN, WEIGHT_MAX);
+    }
+    break;
+  }
+  default:
+    break;
+  }
+
+  for (int c = 0; c < n; c++)
+  {
+    updatePredictionTableState(comp_hybrid[c][ctx->hybrid.index[c]], outcome);
+  }
+}
+
+void cleanup_hybrid()
+{
+  for (int c = 0; c < hybrid_cfg.num_components; c++)
+  {
+    free(comp_hybrid[c]);
+  }
+  free(lht_hybrid);
+  free(chooser_hybrid);
+}
+
+// --------------- Batched simulation ---------------
+// Trace-driven kernels that predict and train a run of records in one
+// call. Counters are handled arithmetically (SN..ST are 0..3) with the
+// masks hoisted out of the loop. Since every outcome is known up front,
+// the global history a few branches ahead is known as well, which lets
+// the kernels prefetch the entries of upcoming branches while working on
+// the current one. Each kernel matches make_prediction/train_predictor
+// record for record.
+
+#define BATCH_LOOKAHEAD 8 // conditional branches prefetched ahead
+
+inline uint8_t counter_update(uint8_t state, uint8_t outcome)
+{
+  return outcome ? (state < ST ? state + 1 : ST) : (state > SN ? state - 1 : SN);
+}
+
+inline void set_prediction_bit(uint64_t *predictions, size_t i, uint8_t prediction)
+{
+  predictions[i >> 6] |= (uint64_t)prediction << (i & 63);
+}
+
+// Walks the records ahead of the current one, keeping the global history
+// each of them will see
+typedef struct
+{
+  const br_record *records;
+  size_t n;
+  size_t next;       // next record to look at
+  uint64_t ghistory; // history seen by records[next]
+} lookahead;
+
+inline void init_lookahead(lookahead *la, const br_record *records, size_t n)
+{
+  la->records = records;
+  la->n = n;
+  la->next = 0;
+  la->ghistory = ghistory;
+}
+
+// Advance to the next conditional branch, returning its index in
+// 'index' and its history in 'hist'
+//
+inline int next_lookahead(lookahead *la, size_t *index, uint64_t *hist)
+{
+  while (la->next < la->n && !la->records[la->next].condition)
+  {
+    la->next++;
+  }
+  if (la->next >= la->n)
+    return 0;
+  *index = la->next;
+  *hist = la->ghistory;
+  la->ghistory = (la->ghistory << 1) | la->records[la->next].outcome;
+  la->next++;
+  return 1;
+}
+
+void gshare_batch(const br_record *records, size_t n, uint64_t *predictions)
+{
+  uint32_t mask = (1 << ghistoryBits) - 1;
+  uint8_t *bht = bht_gshare;
+  uint64_t hist = ghistory;
+
+  lookahead la;
+  size_t ahead;
+  uint64_t ahead_hist;
+  init_lookahead(&la, records, n);
+  for (int i = 0; i < BATCH_LOOKAHEAD && next_lookahead(&la, &ahead, &ahead_hist); i++)
+  {
+    __builtin_prefetch(&bht[(records[ahead].pc ^ ahead_hist) & mask], 1);
+  }
+
+  for (size_t i = 0; i < n; i++)
+  {
+    const br_record *r = &records[i];
+    if (!r->condition)
+      continue;
+    if (next_lookahead(&la, &ahead, &ahead_hist))
+    {
+      __builtin_prefetch(&bht[(records[ahead].pc ^ ahead_hist) & mask], 1);
+    }
+
+    uint32_t index = (r->pc ^ (uint32_t)hist) & mask;
+    uint8_t state = bht[index];
+    set_prediction_bit(predictions, i, state >> 1);
+    bht[index] = counter_update(state, r->outcome);
+    hist = (hist << 1) | r->outcome;
+  }
+  ghistory = hist;
+}
+
+void tour_batch(const br_record *records, size_t n, uint64_t *predictions)
+{
+  uint32_t gpt_mask = (1 << tour_ghistoryBits) - 1;
+  uint32_t cpt_mask = (1 << tour_choiceBits) - 1;
+  uint32_t lpt_mask = (1 << tour_lhistoryBits) - 1;
+  uint32_t lht_mask = (1 << tour_pcBits) - 1;
+  uint64_t hist = ghistory;
+
+  lookahead la;
+  size_t ahead;
+  uint64_t ahead_hist;
+  init_lookahead(&la, records, n);
+  for (int i = 0; i < BATCH_LOOKAHEAD && next_lookahead(&la, &ahead, &ahead_hist); i++)
+  {
+    __builtin_prefetch(&gpt_tour[ahead_hist & gpt_mask], 1);
+    __builtin_prefetch(&cpt_tour[ahead_hist & cpt_mask], 1);
+  }
+
+  for (size_t i = 0; i < n; i++)
+  {
+    const br_record *r = &records[i];
+    if (!r->condition)
+      continue;
+    if (next_lookahead(&la, &ahead, &ahead_hist))
+    {
+      __builtin_prefetch(&gpt_tour[ahead_hist & gpt_mask], 1);
+      __builtin_prefetch(&cpt_tour[ahead_hist & cpt_mask], 1);
+    }
+
+    uint8_t outcome = r->outcome;
+    uint32_t gpt_index = (uint32_t)hist & gpt_mask;
+    uint32_t cpt_index = (uint32_t)hist & cpt_mask;
+    uint16_t *lht_entry = &lht_tour[r->pc & lht_mask];
+    uint32_t lpt_index = *lht_entry & lpt_mask;
+
+    uint8_t gpt_state = gpt_tour[gpt_index];
+    uint8_t lpt_state = lpt_tour[lpt_index];
+    uint8_t cpt_state = cpt_tour[cpt_index];
+    set_prediction_bit(predictions, i, (cpt_state >= WG ? gpt_state : lpt_state) >> 1);
+
+    // The chooser trains on the components' updated predictions
+    gpt_state = counter_update(gpt_state, outcome);
+    lpt_state = counter_update(lpt_state, outcome);
+    gpt_tour[gpt_index] = gpt_state;
+    lpt_tour[lpt_index] = lpt_state;
+    if ((gpt_state >> 1) != (lpt_state >> 1))
+    {
+      cpt_tour[cpt_index] = counter_update(cpt_state, outcome == (gpt_state >> 1));
+    }
+
+    hist = (hist << 1) | outcome;
+    *lht_entry = (*lht_entry << 1) | outcome;
+  }
+  ghistory = hist;
+}
+
+void YAGS_batch(const br_record *records, size_t n, uint64_t *predictions)
+{
+  uint32_t lpt_mask = (1 << YAGS_lhistoryBits) - 1;
+  uint32_t lht_mask = (1 << YAGS_pcBits) - 1;
+  uint32_t cache_mask = (1 << YAGS_ghistoryBits) - 1;
+  int set_index_bits = YAGS_cacheBits - 1;
+  uint32_t set_mask = (1 << set_index_bits) - 1;
+  uint64_t hist = ghistory;
+
+  lookahead la;
+  size_t ahead;
+  uint64_t ahead_hist;
+  init_lookahead(&la, records, n);
+  for (int i = 0; i < BATCH_LOOKAHEAD && next_lookahead(&la, &ahead, &ahead_hist); i++)
+  {
+    uint32_t set = ((records[ahead].pc ^ ahead_hist) & set_mask) << 1;
+    __builtin_prefetch(&TCache_tag_YAGS[set]);
+    __builtin_prefetch(&NTCache_tag_YAGS[set]);
+  }
+
+  for (size_t i = 0; i < n; i++)
+  {
+    const br_record *r = &records[i];
+    if (!r->condition)
+      continue;
+    if (next_lookahead(&la, &ahead, &ahead_hist))
+    {
+      uint32_t set = ((records[ahead].pc ^ ahead_hist) & set_mask) << 1;
+      __builtin_prefetch(&TCache_tag_YAGS[set]);
+      __builtin_prefetch(&NTCache_tag_YAGS[set]);
+    }
+
+    uint8_t outcome = r->outcome;
+    uint16_t *lht_entry = &lht_YAGS[r->pc & lht_mask];
+    uint32_t lpt_index = *lht_entry & lpt_mask;
+    uint32_t cache_index = (r->pc ^ (uint32_t)hist) & cache_mask;
+    uint32_t set_index = cache_index & set_mask;
+    uint16_t tag = cache_index >> set_index_bits;
+    uint32_t way_0 = set_index << 1;
+
+    // Predict: a taken bias looks for exceptions in the NT cache, and a
+    // not-taken bias in the T cache
+    uint8_t lpt_prediction = lpt_YAGS[lpt_index] >> 1;
+    uint16_t *tags = lpt_prediction ? NTCache_tag_YAGS : TCache_tag_YAGS;
+    uint8_t *counters = lpt_prediction ? NTCache_counter_YAGS : TCache_counter_YAGS;
+    uint8_t prediction = lpt_prediction;
+    if (tags[way_0] == tag)
+      prediction = counters[way_0] >> 1;
+    else if (tags[way_0 + 1] == tag)
+      prediction = counters[way_0 + 1] >> 1;
+    set_prediction_bit(predictions, i, prediction);
+
+    // Train: the cache is picked again with the updated bias
+    uint8_t lpt_state = counter_update(lpt_YAGS[lpt_index], outcome);
+    lpt_YAGS[lpt_index] = lpt_state;
+    lpt_prediction = lpt_state >> 1;
+    tags = lpt_prediction ? NTCache_tag_YAGS : TCache_tag_YAGS;
+    counters = lpt_prediction ? NTCache_counter_YAGS : TCache_counter_YAGS;
+    uint8_t *lru = lpt_prediction ? NTCache_LRU_YAGS : TCache_LRU_YAGS;
+
+    if (tags[way_0] == tag)
+    {
+      counters[way_0] = counter_update(counters[way_0], outcome);
+      lru[set_index] = 1;
+    }
+    else if (tags[way_0 + 1] == tag)
+    {
+      counters[way_0 + 1] = counter_update(counters[way_0 + 1], outcome);
+      lru[set_index] = 0;
+    }
+    else if (outcome != lpt_prediction)
+    {
+      // Replace an entry that agrees with the bias, else the LRU one
+      uint32_t way;
+      if ((counters[way_0] >> 1) == lpt_prediction)
+        way = 0;
+      else if ((counters[way_0 + 1] >> 1) == lpt_prediction)
+        way = 1;
+      else
+        way = lru[set_index];
+      tags[way_0 + way] = tag;
+      counters[way_0 + way] = outcome ? WT : WN;
+      lru[set_index] = !way;
+    }
+
+    hist = (hist << 1) | outcome;
+    *lht_entry = (*lht_entry << 1) | outcome;
+  }
+  ghistory = hist;
+}
+
+// --------------- Checkpoint / restore ---------------
+// Snapshot layout (native endianness):
+//   header : magic, version, bpType, ghistory
+//   config : number of sizing parameters, then the parameters themselves
+//   tables : for each table, its size in bytes followed by the raw contents
+// A snapshot is only accepted by a predictor with the same type and sizing.
+
+#define STATE_MAGIC   0x54535042 // "BPST"
+#define STATE_VERSION 1
+
+int write_block(FILE *f, const void *data, size_t bytes)
+{
+  return fwrite(data, 1, bytes, f) == bytes;
+}
+
+int read_block(FILE *f, void *data, size_t bytes)
+{
+  return fread(data, 1, bytes, f) == bytes;
+}
+
+int save_config(FILE *f, const int *params, uint32_t n)
+{
+  return write_block(f, &n, sizeof(n)) && write_block(f, params, n * sizeof(int));
+}
+
+int check_config(FILE *f, const int *params, uint32_t n)
+{
+  uint32_t saved_n = 0;
+  int saved[32];
+  if (!read_block(f, &saved_n, sizeof(saved_n)) || saved_n != n || n > 32)
+    return 0;
+  if (!read_block(f, saved, n * sizeof(int)))
+    return 0;
+  for (uint32_t i = 0; i < n; i++)
+  {
+    if (saved[i] != params[i])
+    {
+      printf("Warning: snapshot parameter %u is %d, predictor uses %d\n", i, saved[i], params[i]);
+      return 0;
+    }
+  }
+  return 1;
+}
+
+int save_table(FILE *f, const void *table, uint64_t bytes)
+{
+  return write_block(f, &bytes, sizeof(bytes)) && write_block(f, table, bytes);
+}
+
+int load_table(FILE *f, void *table, uint64_t bytes)
+{
+  uint64_t saved_bytes = 0;
+  if (!read_block(f, &saved_bytes, sizeof(saved_bytes)) || saved_bytes != bytes)
+    return 0;
+  return read_block(f, table, bytes);
+}
+
+int save_gshare(FILE *f)
+{
+  int params[] = {ghistoryBits};
+  uint64_t bht_entries = 1 << ghistoryBits;
+  return save_config(f, params, 1) &&
+         save_table(f, bht_gshare, bht_entries * sizeof(uint8_t));
+}
+
+int load_gshare(FILE *f)
+{
+  int params[] = {ghistoryBits};
+  uint64_t bht_entries = 1 << ghistoryBits;
+  return check_config(f, params, 1) &&
+         load_table(f, bht_gshare, bht_entries * sizeof(uint8_t));
+}
+
+int save_tour(FILE *f)
+{
+  int params[] = {tour_choiceBits, tour_ghistoryBits, tour_lhistoryBits, tour_pcBits};
+  uint64_t gpt_entries = 1 << tour_ghistoryBits;
+  uint64_t cpt_entries = 1 << tour_choiceBits;
+  uint64_t lpt_entries = 1 << tour_lhistoryBits;
+  uint64_t lht_entries = 1 << tour_pcBits;
+  return save_config(f, params, 4) &&
+         save_table(f, gpt_tour, gpt_entries * sizeof(uint8_t)) &&
+         save_table(f, cpt_tour, cpt_entries * sizeof(uint8_t)) &&
+         save_table(f, lpt_tour, lpt_entries * sizeof(uint8_t)) &&
+         save_table(f, lht_tour, lht_entries * sizeof(uint16_t));
+}
+
+int load_tour(FILE *f)
+{
+  int params[] = {tour_choiceBits, tour_ghistoryBits, tour_lhistoryBits, tour_pcBits};
+  uint64_t gpt_entries = 1 << tour_ghistoryBits;
+  uint64_t cpt_entries = 1 << tour_choiceBits;
+  uint64_t lpt_entries = 1 << tour_lhistoryBits;
+  uint64_t lht_entries = 1 << tour_pcBits;
+  return check_config(f, params, 4) &&
+         load_table(f, gpt_tour, gpt_entries * sizeof(uint8_t)) &&
+         load_table(f, cpt_tour, cpt_entries * sizeof(uint8_t)) &&
+         load_table(f, lpt_tour, lpt_entries * sizeof(uint8_t)) &&
+         load_table(f, lht_tour, lht_entries * sizeof(uint16_t));
+}
+
+int save_YAGS(FILE *f)
+{
+  int params[] = {YAGS_cacheBits, YAGS_ghistoryBits, YAGS_lhistoryBits, YAGS_pcBits};
+  uint64_t cache_entries = 1 << YAGS_cacheBits;
+  uint64_t lpt_entries   = 1 << YAGS_lhistoryBits;
+  uint64_t lht_entries   = 1 << YAGS_pcBits;
+  return save_config(f, params, 4) &&
+         save_table(f, lpt_YAGS, lpt_entries * sizeof(uint8_t)) &&
+         save_table(f, lht_YAGS, lht_entries * sizeof(uint16_t)) &&
+         save_table(f, TCache_tag_YAGS,      cache_entries * sizeof(uint16_t)) &&
+         save_table(f, TCache_counter_YAGS,  cache_entries * sizeof(uint8_t)) &&
+         save_table(f, TCache_LRU_YAGS,      (cache_entries >> 1) * sizeof(uint8_t)) &&
+         save_table(f, NTCache_tag_YAGS,     cache_entries * sizeof(uint16_t)) &&
+         save_table(f, NTCache_counter_YAGS, cache_entries * sizeof(uint8_t)) &&
+         save_table(f, NTCache_LRU_YAGS,     (cache_entries >> 1) * sizeof(uint8_t));
+}
+
+int load_YAGS(FILE *f)
+{
+  int params[] = {YAGS_cacheBits, YAGS_ghistoryBits, YAGS_lhistoryBits, YAGS_pcBits};
+  uint64_t cache_entries = 1 << YAGS_cacheBits;
+  uint64_t lpt_entries   = 1 << YAGS_lhistoryBits;
+  uint64_t lht_entries   = 1 << YAGS_pcBits;
+  return check_config(f, params, 4) &&
+         load_table(f, lpt_YAGS, lpt_entries * sizeof(uint8_t)) &&
+         load_table(f, lht_YAGS, lht_entries * sizeof(uint16_t)) &&
+         load_table(f, TCache_tag_YAGS,      cache_entries * sizeof(uint16_t)) &&
+         load_table(f, TCache_counter_YAGS,  cache_entries * sizeof(uint8_t)) &&
+         load_table(f, TCache_LRU_YAGS,      (cache_entries >> 1) * sizeof(uint8_t)) &&
+         load_table(f, NTCache_tag_YAGS,     cache_entries * sizeof(uint16_t)) &&
+         load_table(f, NTCache_counter_YAGS, cache_entries * sizeof(uint8_t)) &&
+         load_table(f, NTCache_LRU_YAGS,     (cache_entries >> 1) * sizeof(uint8_t));
+}
+
+// The configuration holds the chooser setup and every component
+//
+int hybrid_params(int *params)
+{
+  int n = 0;
+  params[n++] = hybrid_cfg.num_components;
+  params[n++] = hybrid_cfg.chooser;
+  params[n++] = hybrid_cfg.index;
+  params[n++] = hybrid_cfg.chooserBits;
+  params[n++] = hybrid_cfg.pcBits;
+  for (int c = 0; c < hybrid_cfg.num_components; c++)
+  {
+    params[n++] = hybrid_cfg.components[c].kind;
+    params[n++] = hybrid_cfg.components[c].bits;
+  }
+  return n;
+}
+
+int save_hybrid(FILE *f)
+{
+  int params[5 + 2 * MAX_HYBRID_COMPONENTS];
+  int n = hybrid_params(params);
+  uint64_t lht_entries = 1 << hybrid_cfg.pcBits;
+  uint64_t fields = (1 << hybrid_cfg.chooserBits) * (hybrid_cfg.num_components + 1);
+  if (!save_config(f, params, n) ||
+      !save_table(f, lht_hybrid, lht_entries * sizeof(uint16_t)) ||
+      !save_table(f, chooser_hybrid, fields * sizeof(int8_t)))
+    return 0;
+  for (int c = 0; c < hybrid_cfg.num_components; c++)
+  {
+    uint64_t entries = 1 << hybrid_cfg.components[c].bits;
+    if (!save_table(f, comp_hybrid[c], entries * sizeof(uint8_t)))
+      return 0;
+  }
+  return 1;
+}
+
+int load_hybrid(FILE *f)
+{
+  int params[5 + 2 * MAX_HYBRID_COMPONENTS];
+  int n = hybrid_params(params);
+  uint64_t lht_entries = 1 << hybrid_cfg.pcBits;
+  uint64_t fields = (1 << hybrid_cfg.chooserBits) * (hybrid_cfg.num_components + 1);
+  if (!check_config(f, params, n) ||
+      !load_table(f, lht_hybrid, lht_entries * sizeof(uint16_t)) ||
+      !load_table(f, chooser_hybrid, fields * sizeof(int8_t)))
+    return 0;
+  for (int c = 0; c < hybrid_cfg.num_components; c++)
+  {
+    uint64_t entries = 1 << hybrid_cfg.components[c].bits;
+    if (!load_table(f, comp_hybrid[c], entries * sizeof(uint8_t)))
+      return 0;
+  }
+  return 1;
+}
+
+// --------------- Storage budget ---------------
+
+void declare_table(bp_table *tables, int *n, const char *name, uint32_t entries, uint32_t width,
+                   uint32_t assoc)
+{
+  bp_table *t = &tables[(*n)++];
+  t->name = name;
+  t->entries = entries;
+  t->width = width;
+  t->assoc = assoc;
+  t->ports = 1;
+}
+
+// Component tables are named after their kind and position
+char hybrid_table_names[MAX_HYBRID_COMPONENTS][24];
+
+// History bits the hybrid components and chooser use
+//
+void hybrid_history_bits(int *ghistory_bits, int *lhistory_bits)
+{
+  *ghistory_bits = (hybrid_cfg.index == INDEX_PC) ? 0 : hybrid_cfg.chooserBits;
+  *lhistory_bits = 0;
+  for (int c = 0; c < hybrid_cfg.num_components; c++)
+  {
+    hybrid_component *comp = &hybrid_cfg.components[c];
+    if (comp->kind == COMP_LOCAL && comp->bits > *lhistory_bits)
+      *lhistory_bits = comp->bits;
+    if ((comp->kind == COMP_GLOBAL || comp->kind == COMP_GSHARE) && comp->bits > *ghistory_bits)
+      *ghistory_bits = comp->bits;
+  }
+}
+
+int declare_hybrid_tables(bp_table *tables)
+{
+  int n = 0;
+  int comps = hybrid_cfg.num_components;
+  int ghistory_bits, lhistory_bits;
+  hybrid_history_bits(&ghistory_bits, &lhistory_bits);
+  int field_bits = (hybrid_cfg.chooser == CHOOSE_TABLES) ? 2 * comps
+                   : (hybrid_cfg.chooser == CHOOSE_VOTE) ? 3 * comps : 8 * (comps + 1);
+
+  if (ghistory_bits > 0)
+    declare_table(tables, &n, "ghistory", 1, ghistory_bits, 1);
+  if (lhistory_bits > 0)
+    declare_table(tables, &n, "lht_hybrid", 1 << hybrid_cfg.pcBits, lhistory_bits, 1);
+  declare_table(tables, &n, "chooser_hybrid", 1 << hybrid_cfg.chooserBits, field_bits, 1);
+  for (int c = 0; c < comps; c++)
+  {
+    snprintf(hybrid_table_names[c], sizeof(hybrid_table_names[c]), "%s%d_hybrid",
+             compName[hybrid_cfg.components[c].kind], c);
+    declare_table(tables, &n, hybrid_table_names[c], 1 << hybrid_cfg.components[c].bits, 2, 1);
+  }
+  return n;
+}
+
+int declare_tables(bp_table *tables)
+{
+  int n = 0;
+  int tag_bits = YAGS_ghistoryBits - (YAGS_cacheBits - 1);
+  switch (bpType)
+  {
+  case GSHARE:
+    declare_table(tables, &n, "ghistory", 1, ghistoryBits, 1);
+    declare_table(tables, &n, "bht_gshare", 1 << ghistoryBits, 2, 1);
+    break;
+  case TOURNAMENT:
+    declare_table(tables, &n, "ghistory", 1,
+                  tour_ghistoryBits > tour_choiceBits ? tour_ghistoryBits : tour_choiceBits, 1);
+    declare_table(tables, &n, "gpt_tour", 1 << tour_ghistoryBits, 2, 1);
+    declare_table(tables, &n, "cpt_tour", 1 << tour_choiceBits, 2, 1);
+    declare_table(tables, &n, "lpt_tour", 1 << tour_lhistoryBits, 2, 1);
+    declare_table(tables, &n, "lht_tour", 1 << tour_pcBits, tour_lhistoryBits, 1);
+    break;
+  case CUSTOM:
+    declare_table(tables, &n, "ghistory", 1, YAGS_ghistoryBits, 1);
+    declare_table(tables, &n, "lpt_YAGS", 1 << YAGS_lhistoryBits, 2, 1);
+    declare_table(tables, &n, "lht_YAGS", 1 << YAGS_pcBits, YAGS_lhistoryBits, 1);
+    declare_table(tables, &n, "TCache_YAGS", 1 << YAGS_cacheBits, tag_bits + 2, 2);
+    declare_table(tables, &n, "TCache_LRU_YAGS", 1 << (YAGS_cacheBits - 1), 1, 1);
+    declare_table(tables, &n, "NTCache_YAGS", 1 << YAGS_cacheBits, tag_bits + 2, 2);
+    declare_table(tables, &n, "NTCache_LRU_YAGS", 1 << (YAGS_cacheBits - 1), 1, 1);
+    break;
+  case HYBRID:
+    n = declare_hybrid_tables(tables);
+    break;
+  default:
+    break;
+  }
+  return n;
+}
+
+uint64_t predictor_budget()
+{
+  bp_table tables[MAX_BP_TABLES];
+  int n = declare_tables(tables);
+  uint64_t bits = 0;
+  for (int i = 0; i < n; i++)
+  {
+    bits += (uint64_t)tables[i].entries * tables[i].width;
+  }
+  return bits;
+}
+
+void print_budget()
+{
+  bp_table tables[MAX_BP_TABLES];
+  int n = declare_tables(tables);
+  printf("Storage:\n");
+  printf("  %-18s  %9s  %5s  %5s  %12s\n", "Structure", "Entries", "Width", "Ways", "Bits");
+  for (int i = 0; i < n; i++)
+  {
+    bp_table *t = &tables[i];
+    printf("  %-18s  %9u  %5u  %5u  %12llu\n", t->name, t->entries, t->width, t->assoc,
+           (unsigned long long)t->entries * t->width);
+  }
+  uint64_t bits = predictor_budget();
+  printf("Budget:          %10llu bits (%.2f KiB)\n", (unsigned long long)bits, bits / 8192.0);
+}
+
+void add_lookup(bp_lookup *lookups, int *n, int table, uint32_t index)
+{
+  lookups[*n].table = table;
+  lookups[*n].index = index;
+  (*n)++;
+}
+
+// Table numbers follow the order of declare_tables
+//
+int context_lookups(uint32_t pc, const bp_context *ctx, bp_lookup *lookups)
+{
+  int n = 0;
+  switch (bpType)
+  {
+  case GSHARE:
+    add_lookup(lookups, &n, 1, ctx->gshare.index);
+    break;
+  case TOURNAMENT:
+    add_lookup(lookups, &n, 1, ctx->tour.gpt_index);
+    add_lookup(lookups, &n, 2, ctx->tour.cpt_index);
+    add_lookup(lookups, &n, 3, ctx->tour.lpt_index);
+    add_lookup(lookups, &n, 4, pc & ((1 << tour_pcBits) - 1));
+    break;
+  case CUSTOM:
+    // Both caches are read in parallel with the LPT
+    add_lookup(lookups, &n, 1, ctx->yags.lpt_index);
+    add_lookup(lookups, &n, 2, pc & ((1 << YAGS_pcBits) - 1));
+    add_lookup(lookups, &n, 3, ctx->yags.set_index);
+    add_lookup(lookups, &n, 5, ctx->yags.set_index);
+    break;
+  case HYBRID:
+  {
+    int ghistory_bits, lhistory_bits;
+    hybrid_history_bits(&ghistory_bits, &lhistory_bits);
+    int table = (ghistory_bits > 0);
+    if (lhistory_bits > 0)
+      add_lookup(lookups, &n, table++, pc & ((1 << hybrid_cfg.pcBits) - 1));
+    add_lookup(lookups, &n, table++, ctx->hybrid.chooser_index);
+    for (int c = 0; c < hybrid_cfg.num_components; c++)
+    {
+      add_lookup(lookups, &n, table++, ctx->hybrid.index[c]);
+    }
+    break;
+  }
+  default:
+    break;
+  }
+  return n;
+}
+
+#ifdef BP_ACCESS_STATS
+// --------------- Access counting ---------------
+// Every trained branch reads the entries its prediction looked up, the
+// history registers and both ways of a tagged set, and writes what its
+// training updates. Counted before the update, in the table order of
+// declare_tables.
+
+void access_record(uint32_t pc, uint8_t outcome, const bp_context *ctx)
+{
+  bp_lookup lookups[MAX_BP_LOOKUPS];
+  int n = context_lookups(pc, ctx, lookups);
+  for (int i = 0; i < n; i++)
+  {
+    count_access(lookups[i].table, 1, 0, 0);
+  }
+  count_access_branch();
+
+  switch (bpType)
+  {
+  case GSHARE:
+    count_access(0, 1, 1, 0);
+    count_access(1, 0, 1, 0);
+    break;
+  case TOURNAMENT:
+  {
+    count_access(0, 1, 1, 0);
+    count_access(1, 0, 1, 0);
+    count_access(3, 0, 1, 0);
+    count_access(4, 0, 1, 0);
+    // The chooser trains on the updated component predictions
+    uint8_t gpt_prediction = getPrediction(counter_update(gpt_tour[ctx->tour.gpt_index], outcome));
+    uint8_t lpt_prediction = getPrediction(counter_update(lpt_tour[ctx->tour.lpt_index], outcome));
+    if (gpt_prediction != lpt_prediction)
+      count_access(2, 0, 1, 0);
+    break;
+  }
+  case CUSTOM:
+  {
+    count_access(0, 1, 1, 0);
+    count_access(1, 0, 1, 0);
+    count_access(2, 0, 1, 0);
+    count_access(3, 0, 0, 2);
+    count_access(5, 0, 0, 2);
+    // Training picks the cache with the updated LPT prediction; a hit
+    // updates its counter, a miss the LPT got wrong replaces a way
+    uint8_t lpt_prediction = getPrediction(counter_update(lpt_YAGS[ctx->yags.lpt_index], outcome));
+    int cache = (lpt_prediction == TAKEN) ? 5 : 3;
+    uint16_t *tags = (lpt_prediction == TAKEN) ? NTCache_tag_YAGS : TCache_tag_YAGS;
+    uint32_t way = ctx->yags.set_index << 1;
+    int hit = tags[way] == ctx->yags.tag || tags[way + 1] == ctx->yags.tag;
+    if (hit || outcome != lpt_prediction)
+    {
+      count_access(cache, 0, 1, 0);
+      count_access(cache + 1, hit ? 0 : 1, 1, 0);
+    }
+    break;
+  }
+  case HYBRID:
+  {
+    int ghistory_bits, lhistory_bits;
+    hybrid_history_bits(&ghistory_bits, &lhistory_bits);
+    if (ghistory_bits > 0)
+      count_access(0, 1, 1, 0);
+    int i = 0;
+    if (lhistory_bits > 0)
+      count_access(lookups[i++].table, 0, 1, 0);
+    if (hybrid_trains_chooser(outcome, ctx))
+      count_access(lookups[i].table, 0, 1, 0);
+    for (i++; i < n; i++)
+    {
+      count_access(lookups[i].table, 0, 1, 0);
+    }
+    break;
+  }
+  default:
+    break;
+  }
+}
+#endif
+
+// --------------- Configuration ---------------
+
+const char *specName[5] = {"static", "gshare", "tournament", "custom", "hybrid"};
+
+// A size that a spec string may set
+typedef struct
+{
+  int type;
+  const char *key;
+  size_t offset; // of the size in bp_config
+  int min_bits;
+  int max_bits;
+} spec_param;
+
+// Local histories are kept in 16-bit registers
+spec_param spec_params[] = {
+    {GSHARE, "hist", offsetof(bp_config, gshare.historyBits), 1, 28},
+    {TOURNAMENT, "choice", offsetof(bp_config, tour.choiceBits), 1, 28},
+    {TOURNAMENT, "global", offsetof(bp_config, tour.ghistoryBits), 1, 28},
+    {TOURNAMENT, "local", offsetof(bp_config, tour.lhistoryBits), 1, 16},
+    {TOURNAMENT, "pc", offsetof(bp_config, tour.pcBits), 1, 24},
+    {CUSTOM, "cache", offsetof(bp_config, yags.cacheBits), 2, 28},
+    {CUSTOM, "global", offsetof(bp_config, yags.ghistoryBits), 1, 28},
+    {CUSTOM, "local", offsetof(bp_config, yags.lhistoryBits), 1, 16},
+    {CUSTOM, "pc", offsetof(bp_config, yags.pcBits), 1, 24},
+    {HYBRID, "choice", offsetof(bp_config, hybrid.chooserBits), 1, 24},
+    {HYBRID, "pc", offsetof(bp_config, hybrid.pcBits), 1, 24},
+};
+#define NUM_SPEC_PARAMS (sizeof(spec_params) / sizeof(spec_params[0]))
+
+int *config_size(bp_config *cfg, const spec_param *param)
+{
+  return (int *)((char *)cfg + param->offset);
+}
+
+void get_config(bp_config *cfg)
+{
+  cfg->type = bpType;
+  cfg->hybrid = hybrid_cfg;
+  cfg->gshare.historyBits = ghistoryBits;
+  cfg->tour.choiceBits = tour_choiceBits;
+  cfg->tour.ghistoryBits = tour_ghistoryBits;
+  cfg->tour.lhistoryBits = tour_lhistoryBits;
+  cfg->tour.pcBits = tour_pcBits;
+  cfg->yags.cacheBits = YAGS_cacheBits;
+  cfg->yags.ghistoryBits = YAGS_ghistoryBits;
+  cfg->yags.lhistoryBits = YAGS_lhistoryBits;
+  cfg->yags.pcBits = YAGS_pcBits;
+}
+
+void set_config(const bp_config *cfg)
+{
+  bpType = cfg->type;
+  hybrid_cfg = cfg->hybrid;
+  ghistoryBits = cfg->gshare.historyBits;
+  tour_choiceBits = cfg->tour.choiceBits;
+  tour_ghistoryBits = cfg->tour.ghistoryBits;
+  tour_lhistoryBits = cfg->tour.lhistoryBits;
+  tour_pcBits = cfg->tour.pcBits;
+  YAGS_cacheBits = cfg->yags.cacheBits;
+  YAGS_ghistoryBits = cfg->yags.ghistoryBits;
+  YAGS_lhistoryBits = cfg->yags.lhistoryBits;
+  YAGS_pcBits = cfg->yags.pcBits;
+}
+
+int find_name(const char **names, int n, const char *word, size_t len)
+{
+  for (int i = 0; i < n; i++)
+  {
+    if (strlen(names[i]) == len && !strncmp(word, names[i], len))
+      return i;
+  }
+  return -1;
+}
+
+// Hybrid parameters that are not plain sizes: components are listed as
+// <kind>=<bits> in order, replacing the active list, and the chooser is
+// set with choose=<tables|vote|perceptron>, index=<pc|hist|pcxhist>
+//
+// Returns 1 if the parameter was taken, -1 if it is invalid, and 0 if
+// it is not one of these
+//
+int parse_hybrid_param(hybrid_config *cfg, const char *key, size_t key_len, const char *value,
+                       int *listed)
+{
+  size_t value_len = strcspn(value, ",");
+  int word;
+  if ((word = find_name(compName, 4, key, key_len)) >= 0)
+  {
+    char *end;
+    long bits = strtol(value, &end, 10);
+    int max_bits = (word == COMP_LOCAL) ? 16 : 28;
+    if (end != value + value_len || bits < 1 || bits > max_bits)
+    {
+      printf("hybrid %s needs 1 to %d bits\n", compName[word], max_bits);
+      return -1;
+    }
+    if (!*listed)
+      cfg->num_components = 0;
+    *listed = 1;
+    if (cfg->num_components == MAX_HYBRID_COMPONENTS)
+    {
+      printf("hybrid takes at most %d components\n", MAX_HYBRID_COMPONENTS);
+      return -1;
+    }
+    cfg->components[cfg->num_components].kind = word;
+    cfg->components[cfg->num_components].bits = (int)bits;
+    cfg->num_components++;
+    return 1;
+  }
+  if (key_len == 6 && !strncmp(key, "choose", 6))
+  {
+    if ((word = find_name(chooseName, 3, value, value_len)) < 0)
+    {
+      printf("hybrid choose is tables, vote or perceptron\n");
+      return -1;
+    }
+    cfg->chooser = word;
+    return 1;
+  }
+  if (key_len == 5 && !strncmp(key, "index", 5))
+  {
+    if ((word = find_name(indexName, 3, value, value_len)) < 0)
+    {
+      printf("hybrid index is pc, hist or pcxhist\n");
+      return -1;
+    }
+    cfg->index = word;
+    return 1;
+  }
+  return 0;
+}
+
+int parse_predictor_spec(const char *spec, bp_config *cfg)
+{
+  size_t name_len = strcspn(spec, ":");
+  int type = find_name(specName, 5, spec, name_len);
+  if (type < 0)
+    return 0;
+
+  get_config(cfg);
+  cfg->type = type;
+  const char *p = spec + name_len;
+  int listed = 0;
+  while (*p == ':' || *p == ',')
+  {
+    p++;
+    size_t key_len = strcspn(p, "=,");
+    if (type == HYBRID && p[key_len] == '=')
+    {
+      int taken = parse_hybrid_param(&cfg->hybrid, p, key_len, p + key_len + 1, &listed);
+      if (taken < 0)
+        return 0;
+      if (taken > 0)
+      {
+        p += key_len + 1 + strcspn(p + key_len + 1, ",");
+        continue;
+      }
+    }
+    const spec_param *param = NULL;
+    for (size_t i = 0; i < NUM_SPEC_PARAMS; i++)
+    {
+      if (spec_params[i].type == type && strlen(spec_params[i].key) == key_len &&
+          !strncmp(p, spec_params[i].key, key_len))
+        param = &spec_params[i];
+    }
+    if (param == NULL || p[key_len] != '=')
+    {
+      printf("Unknown %s parameter '%.*s'\n", specName[type], (int)key_len, p);
+      return 0;
+    }
+    char *end;
+    long bits = strtol(p + key_len + 1, &end, 10);
+    if (end == p + key_len + 1 || (*end != ',' && *end != '\0') ||
+        bits < param->min_bits || bits > param->max_bits)
+    {
+      printf("%s %s needs %d to %d bits\n", specName[type], param->key, param->min_bits, param->max_bits);
+      return 0;
+    }
+    *config_size(cfg, param) = (int)bits;
+    p = end;
+  }
+  if (*p != '\0')
+    return 0;
+
+  // YAGS tags are what the cache index leaves of the global history
+  int tag_bits = cfg->yags.ghistoryBits - (cfg->yags.cacheBits - 1);
+  if (type == CUSTOM && (tag_bits < 0 || tag_bits > 16))
+  {
+    printf("custom global needs cache - 1 to cache + 15 bits\n");
+    return 0;
+  }
+  return 1;
+}
+
+void format_predictor_spec(const bp_config *cfg, char *buf, size_t size)
+{
+  int len = snprintf(buf, size, "%s", specName[cfg->type]);
+  char sep = ':';
+  if (cfg->type == HYBRID)
+  {
+    const hybrid_config *h = &cfg->hybrid;
+    for (int c = 0; c < h->num_components && len < (int)size; c++)
+    {
+      len += snprintf(buf + len, size - len, "%c%s=%d", sep, compName[h->components[c].kind],
+                      h->components[c].bits);
+      sep = ',';
+    }
+    if (len < (int)size)
+      len += snprintf(buf + len, size - len, ",choose=%s,index=%s", chooseName[h->chooser],
+                      indexName[h->index]);
+  }
+  for (size_t i = 0; i < NUM_SPEC_PARAMS && len < (int)size; i++)
+  {
+    if (spec_params[i].type == cfg->type)
+    {
+      len += snprintf(buf + len, size - len, "%c%s=%d", sep, spec_params[i].key,
+                      *config_size((bp_config *)cfg, &spec_params[i]));
+      sep = ',';
+    }
+  }
+}
+
+// ============================================================
+
+void init_predictor()
+{
+  switch (bpType)
+  {
+  case STATIC:
+    break;
+  case GSHARE:
+    init_gshare();
+    break;
+  case TOURNAMENT:
+    init_tour();
+    break;
+  case CUSTOM:
+    init_YAGS();
+    break;
+  case HYBRID:
+    init_hybrid();
+    break;
+  default:
+    break;
+  }
+#ifdef BP_ALIAS_STATS
+  register_alias_tables();
+#endif
+#ifdef BP_ACCESS_STATS
+  init_access_stats();
+#endif
+}
+
+// Capture the histories a prediction for the branch at PC 'pc' is made
+// with and locate the entries it reads, so that training later updates
+// the same entries
+//
+void capture_context(uint32_t pc, bp_context *ctx)
+{
+  ctx->ghistory = ghistory;
+  ctx->lhistory = 0;
+  switch (bpType)
+  {
+  case TOURNAMENT:
+    ctx->lhistory = lht_tour[pc & ((1 << tour_pcBits) - 1)];
+    break;
+  case CUSTOM:
+    ctx->lhistory = lht_YAGS[pc & ((1 << YAGS_pcBits) - 1)];
+    break;
+  case HYBRID:
+    ctx->lhistory = lht_hybrid[pc & ((1 << hybrid_cfg.pcBits) - 1)];
+    break;
+  default:
+    break;
+  }
+
+  // Locate the entries the prediction reads and training updates
+  switch (bpType)
+  {
+  case GSHARE:
+    gshare_locate(pc, ctx);
+    break;
+  case TOURNAMENT:
+    tour_locate(ctx);
+    break;
+  case CUSTOM:
+    YAGS_locate(pc, ctx);
+    break;
+  case HYBRID:
+    hybrid_locate(pc, ctx);
+    break;
+  default:
+    break;
+  }
+}
+
+// Shift a direction into the global history and the local history of
+// the branch at PC 'pc'
+//
+void update_history(uint32_t pc, uint8_t outcome)
+{
+  uint32_t lht_index;
+  switch (bpType)
+  {
+  case GSHARE:
+    ghistory = ((ghistory << 1) | outcome);
+    break;
+  case TOURNAMENT:
+    ghistory = ((ghistory << 1) | outcome);
+    lht_index = pc & ((1 << tour_pcBits) - 1);
+    lht_tour[lht_index] = ((lht_tour[lht_index] << 1) | outcome);
+    break;
+  case CUSTOM:
+    ghistory = ((ghistory << 1) | outcome);
+    lht_index = pc & ((1 << YAGS_pcBits) - 1);
+    lht_YAGS[lht_index] = ((lht_YAGS[lht_index] << 1) | outcome);
+    break;
+  case HYBRID:
+    ghistory = ((ghistory << 1) | outcome);
+    lht_index = pc & ((1 << hybrid_cfg.pcBits) - 1);
+    lht_hybrid[lht_index] = ((lht_hybrid[lht_index] << 1) | outcome);
+    break;
+  default:
+    break;
+  }
+}
+
+// Roll the histories back to the checkpoint taken before the branch at
+// PC 'pc' was predicted
+//
+void restore_history(uint32_t pc, const bp_context *ctx)
+{
+  ghistory = ctx->ghistory;
+  switch (bpType)
+  {
+  case TOURNAMENT:
+    lht_tour[pc & ((1 << tour_pcBits) - 1)] = ctx->lhistory;
+    break;
+  case CUSTOM:
+    lht_YAGS[pc & ((1 << YAGS_pcBits) - 1)] = ctx->lhistory;
+    break;
+  case HYBRID:
+    lht_hybrid[pc & ((1 << hybrid_cfg.pcBits) - 1)] = ctx->lhistory;
+    break;
+  default:
+    break;
+  }
+}
+
+void squash_prediction(uint32_t pc, const bp_context *ctx)
+{
+  if (spec_history)
+  {
+    restore_history(pc, ctx);
+  }
+}
+
+// Context of the last make_prediction, which train_predictor trains the
+// same branch with: its entries and, for speculative histories, its
+// prediction
+bp_context scalar_ctx;
+uint32_t scalar_pc;
+int scalar_pending = 0;
+
+// Make a prediction for conditional branch instruction at PC 'pc'
+// Returning TAKEN indicates a prediction of taken; returning NOTTAKEN
+// indicates a prediction of not taken
+//
+uint32_t make_prediction(uint32_t pc, uint32_t target, uint32_t direct)
+{
+  scalar_pc = pc;
+  scalar_pending = 1;
+  return make_prediction_ctx(pc, target, direct, &scalar_ctx);
+}
+
+uint32_t make_prediction_ctx(uint32_t pc, uint32_t target, uint32_t direct, bp_context *ctx)
+{
+  capture_context(pc, ctx);
+
+  // Make a prediction based on the bpType
+  // If there is not a compatable bpType then return NOTTAKEN
+  uint8_t prediction = NOTTAKEN;
+  switch (bpType)
+  {
+  case STATIC:
+    prediction = TAKEN;
+    ctx->counter = ST;
+    break;
+  case GSHARE:
+    prediction = gshare_predict(ctx);
+    break;
+  case TOURNAMENT:
+    prediction = tour_predict(ctx);
+    break;
+  case CUSTOM:
+    prediction = YAGS_predict(ctx);
+    break;
+  case HYBRID:
+    prediction = hybrid_predict(ctx);
+    break;
+  default:
+    break;
+  }
+
+  // Speculatively assume the predicted direction until the branch resolves
+  ctx->prediction = prediction;
+  if (spec_history)
+  {
+    update_history(pc, prediction);
+  }
+  return prediction;
+}
+
+// Train the predictor the last executed branch at PC 'pc' and with
+// outcome 'outcome' (true indicates that the branch was taken, false
+// indicates that the branch was not taken)
+//
+
+void train_predictor(uint32_t pc, uint32_t target, uint32_t outcome, uint32_t condition, uint32_t call, uint32_t ret, uint32_t direct)
+{
+  bp_context ctx = scalar_ctx;
+  if (condition && !(scalar_pending && scalar_pc == pc))
+  {
+    // A branch trained without its prediction is predicted first
+    make_prediction_ctx(pc, target, direct, &ctx);
+  }
+  scalar_pending = 0;
+  train_predictor_ctx(pc, target, outcome, condition, call, ret, direct, &ctx);
+}
+
+void train_predictor_ctx(uint32_t pc, uint32_t target, uint32_t outcome, uint32_t condition, uint32_t call, uint32_t ret, uint32_t direct, const bp_context *ctx)
+{
+  if (condition)
+  {
+#ifdef BP_ALIAS_STATS
+    alias_record(pc, outcome, ctx);
+#endif
+#ifdef BP_ACCESS_STATS
+    access_record(pc, outcome, ctx);
+#endif
+    switch (bpType)
+    {
+    case STATIC:
+      return;
+    case GSHARE:
+      train_gshare(outcome, ctx);
+      break;
+    case TOURNAMENT:
+      train_tour(outcome, ctx);
+      break;
+    case CUSTOM:
+      train_YAGS(outcome, ctx);
+      break;
+    case HYBRID:
+      train_hybrid(outcome, ctx);
+      break;
+    default:
+      return;
+    }
+
+    // Speculative histories only need repair after a misprediction
+    if (!spec_history)
+    {
+      update_history(pc, outcome);
+    }
+    else if (outcome != ctx->prediction)
+    {
+      restore_history(pc, ctx);
+      update_history(pc, outcome);
+    }
+  }
+}
+
+// Write the state of the initialized predictor to 'f'
+//
+// Returns True if Successful
+//
+int save_predictor(FILE *f)
+{
+  uint32_t header[3] = {STATE_MAGIC, STATE_VERSION, (uint32_t)bpType};
+  if (!write_block(f, header, sizeof(header)) || !write_block(f, &ghistory, sizeof(ghistory)))
+    return 0;
+
+  switch (bpType)
+  {
+  case STATIC:
+    return 1;
+  case GSHARE:
+    return save_gshare(f);
+  case TOURNAMENT:
+    return save_tour(f);
+  case CUSTOM:
+    return save_YAGS(f);
+  case HYBRID:
+    return save_hybrid(f);
+  default:
+    break;
+  }
+  return 0;
+}
+
+// Restore the state of the initialized predictor from a snapshot
+// written by save_predictor with the same predictor configuration
+//
+// Returns True if Successful
+//
+int load_predictor(FILE *f)
+{
+  uint32_t header[3];
+  if (!read_block(f, header, sizeof(header)))
+    return 0;
+  if (header[0] != STATE_MAGIC || header[1] != STATE_VERSION)
+  {
+    printf("Warning: not a predictor snapshot or unsupported version!\n");
+    return 0;
+  }
+  if (header[2] != (uint32_t)bpType)
+  {
+    printf("Warning: snapshot was taken from a %s predictor!\n",
+           header[2] < 5 ? bpName[header[2]] : "unknown");
+    return 0;
+  }
+  if (!read_block(f, &ghistory, sizeof(ghistory)))
+    return 0;
+
+  switch (bpType)
+  {
+  case STATIC:
+    return 1;
+  case GSHARE:
+    return load_gshare(f);
+  case TOURNAMENT:
+    return load_tour(f);
+  case CUSTOM:
+    return load_YAGS(f);
+  case HYBRID:
+    return load_hybrid(f);
+  default:
+    break;
+  }
+  return 0;
+}
+
+// Every table resets to a single byte value, so flushes are one memset
+// per table rather than the per-entry loops of the init functions
+//
+void flush_predictor(int structures)
+{
+  if (structures & FLUSH_HISTORY)
+    ghistory = 0;
+
+  switch (bpType)
+  {
+  case GSHARE:
+    if (structures & FLUSH_TABLES)
+      memset(bht_gshare, WN, (1 << ghistoryBits) * sizeof(uint8_t));
+    break;
+  case TOURNAMENT:
+    if (structures & FLUSH_HISTORY)
+      memset(lht_tour, 0, (1 << tour_pcBits) * sizeof(uint16_t));
+    if (structures & FLUSH_TABLES)
+    {
+      memset(gpt_tour, WN, (1 << tour_ghistoryBits) * sizeof(uint8_t));
+      memset(lpt_tour, WN, (1 << tour_lhistoryBits) * sizeof(uint8_t));
+    }
+    if (structures & FLUSH_CHOOSER)
+      memset(cpt_tour, WL, (1 << tour_choiceBits) * sizeof(uint8_t));
+    break;
+  case CUSTOM:
+    if (structures & FLUSH_HISTORY)
+      memset(lht_YAGS, 0, (1 << YAGS_pcBits) * sizeof(uint16_t));
+    if (structures & FLUSH_TABLES)
+      memset(lpt_YAGS, WN, (1 << YAGS_lhistoryBits) * sizeof(uint8_t));
+    if (structures & FLUSH_CACHES)
+    {
+      uint32_t cache_entries = 1 << YAGS_cacheBits;
+      memset(TCache_tag_YAGS, 0, cache_entries * sizeof(uint16_t));
+      memset(TCache_counter_YAGS, WN, cache_entries * sizeof(uint8_t));
+      memset(TCache_LRU_YAGS, 0, (cache_entries >> 1) * sizeof(uint8_t));
+      memset(NTCache_tag_YAGS, 0, cache_entries * sizeof(uint16_t));
+      memset(NTCache_counter_YAGS, WN, cache_entries * sizeof(uint8_t));
+      memset(NTCache_LRU_YAGS, 0, (cache_entries >> 1) * sizeof(uint8_t));
+    }
+    break;
+  case HYBRID:
+    if (structures & FLUSH_HISTORY)
+      memset(lht_hybrid, 0, (1 << hybrid_cfg.pcBits) * sizeof(uint16_t));
+    if (structures & FLUSH_TABLES)
+    {
+      for (int c = 0; c < hybrid_cfg.num_components; c++)
+        memset(comp_hybrid[c], WN, (1 << hybrid_cfg.components[c].bits) * sizeof(uint8_t));
+    }
+    if (structures & FLUSH_CHOOSER)
+    {
+      int fields = (1 << hybrid_cfg.chooserBits) * (hybrid_cfg.num_components + 1);
+      memset(chooser_hybrid, hybrid_chooser_init(), fields * sizeof(int8_t));
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+// Batch through the per-branch entry points, for predictors without a
+// kernel of their own
+//
+void per_branch_batch(const br_record *records, size_t n, uint64_t *predictions)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    const br_record *r = &records[i];
+    if (r->condition)
+    {
+      bp_context ctx;
+      uint8_t prediction = make_prediction_ctx(r->pc, r->target, r->direct, &ctx);
+      train_predictor_ctx(r->pc, r->target, r->outcome, r->condition, r->call, r->ret, r->direct, &ctx);
+      set_prediction_bit(predictions, i, prediction);
+    }
+  }
+}
+
+// Predict and train the 'n' records in order, exactly as calling
+// make_prediction and train_predictor for each of them. Bit i of
+// 'predictions' is set when record i is a conditional branch predicted
+// taken; the bitmap needs (n + 63) / 64 words.
+//
+void predict_train_batch(const br_record *records, size_t n, uint64_t *predictions)
+{
+  memset(predictions, 0, ((n + 63) / 64) * sizeof(uint64_t));
+#if defined(BP_ALIAS_STATS) || defined(BP_ACCESS_STATS)
+  // The analyzers hook into the per-branch training path
+  per_branch_batch(records, n, predictions);
+  return;
+#endif
+  switch (bpType)
+  {
+  case STATIC:
+    for (size_t i = 0; i < n; i++)
+    {
+      set_prediction_bit(predictions, i, records[i].condition ? TAKEN : NOTTAKEN);
+    }
+    break;
+  case GSHARE:
+    gshare_batch(records, n, predictions);
+    break;
+  case TOURNAMENT:
+    tour_batch(records, n, predictions);
+    break;
+  case CUSTOM:
+    YAGS_batch(records, n, predictions);
+    break;
+  case HYBRID:
+    per_branch_batch(records, n, predictions);
+    break;
+  default:
+    break;
+  }
 }
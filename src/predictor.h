@@ -77,6 +77,252 @@ void train_predictor(uint32_t pc, uint32_t target, uint32_t outcome, uint32_t co
 // Please add your code below, and DO NOT MODIFY ANY OF THE CODE ABOVE
 // 
 
+#include <stdio.h>
+
+// N-way hybrid of simple component predictors (see hybrid_config)
+#define HYBRID 4
+#define MAX_HYBRID_COMPONENTS 8
+
+// Table sizes of the tournament and custom (YAGS) predictors
+extern int tour_choiceBits;
+extern int tour_ghistoryBits;
+extern int tour_lhistoryBits;
+extern int tour_pcBits;
+extern int YAGS_cacheBits;
+extern int YAGS_ghistoryBits;
+extern int YAGS_lhistoryBits;
+extern int YAGS_pcBits;
+
+// A storage structure of the configured predictor. History registers
+// are declared as single-entry structures.
+typedef struct
+{
+  const char *name;
+  uint32_t entries;
+  uint32_t width; // bits per entry
+  uint32_t assoc; // ways per set, 1 when direct-mapped
+  uint32_t ports; // read/write ports
+} bp_table;
+
+#define MAX_BP_TABLES 16
+
+// Fill 'tables' with the structures of the configured predictor
+//
+// Returns the number of structures
+//
+int declare_tables(bp_table *tables);
+
+// Total storage of the configured predictor in bits
+//
+uint64_t predictor_budget();
+
+// Print the storage of every structure and the total
+//
+void print_budget();
+
+// An entry a prediction reads: its table, numbered as in declare_tables,
+// and its index
+typedef struct
+{
+  int table;
+  uint32_t index;
+} bp_lookup;
+
+#define MAX_BP_LOOKUPS (MAX_HYBRID_COMPONENTS + 2)
+
+// Predictor configuration: the type and the sizes of its tables, as
+// written in a spec string "<type>[:<key>=<bits>,...]", e.g.
+// "gshare:hist=15" or "tournament:choice=12,local=11,pc=10"
+typedef struct
+{
+  int historyBits;
+} gshare_config;
+
+typedef struct
+{
+  int choiceBits;
+  int ghistoryBits;
+  int lhistoryBits;
+  int pcBits;
+} tour_config;
+
+typedef struct
+{
+  int cacheBits;
+  int ghistoryBits;
+  int lhistoryBits;
+  int pcBits;
+} yags_config;
+
+// Hybrid components share the global history and one local history
+// table; each indexes its own counters with some of those bits.
+// Components are the table kinds the other predictors are built from,
+// not the gshare, tournament and YAGS predictors themselves: those keep
+// one global instance of their tables and are dispatched on bpType, so
+// they could neither appear twice nor run side by side. gshare is a
+// single gshare component, and tournament keeps its own chooser as the
+// reference a global+local hybrid with choose=tables is compared with.
+#define COMP_BIMODAL 0 // PC
+#define COMP_GLOBAL 1  // global history
+#define COMP_GSHARE 2  // PC xor global history
+#define COMP_LOCAL 3   // local history
+
+// How the hybrid combines the component predictions
+#define CHOOSE_TABLES 0     // per-component 2-bit usefulness counters
+#define CHOOSE_VOTE 1       // majority vote weighted by 3-bit weights
+#define CHOOSE_PERCEPTRON 2 // perceptron over the component predictions
+
+// What the chooser entries are indexed with
+#define INDEX_PC 0
+#define INDEX_HIST 1
+#define INDEX_PCXHIST 2
+
+typedef struct
+{
+  int kind;
+  int bits; // index bits
+} hybrid_component;
+
+typedef struct
+{
+  int num_components;
+  hybrid_component components[MAX_HYBRID_COMPONENTS];
+  int chooser;
+  int index;
+  int chooserBits;
+  int pcBits; // local history table index bits
+} hybrid_config;
+
+typedef struct
+{
+  int type;
+  hybrid_config hybrid;
+  gshare_config gshare;
+  tour_config tour;
+  yags_config yags;
+} bp_config;
+
+// Read the active configuration, and make 'cfg' the configuration the
+// next init_predictor builds
+//
+void get_config(bp_config *cfg);
+void set_config(const bp_config *cfg);
+
+// Parse a spec string into 'cfg'. Sizes it leaves out keep their
+// values from the active configuration.
+//
+// Returns True if Successful
+//
+int parse_predictor_spec(const char *spec, bp_config *cfg);
+
+// Write the canonical spec string of 'cfg', listing every size; it
+// takes at most MAX_SPEC_LEN bytes
+//
+#define MAX_SPEC_LEN 256
+void format_predictor_spec(const bp_config *cfg, char *buf, size_t size);
+
+// One decoded trace record
+typedef struct
+{
+  uint32_t pc;
+  uint32_t target;
+  uint32_t insts;    // instructions since the previous record, 0 if unknown
+  uint8_t outcome;
+  uint8_t condition;
+  uint8_t call;
+  uint8_t ret;
+  uint8_t direct;
+  uint8_t event;     // an event line of the trace precedes the record
+} br_record;
+
+// Predict and train the 'n' records in order, exactly as calling
+// make_prediction and train_predictor for each of them. Bit i of
+// 'predictions' is set when record i is a conditional branch predicted
+// taken; the bitmap needs (n + 63) / 64 words.
+//
+void predict_train_batch(const br_record *records, size_t n, uint64_t *predictions);
+
+// Prediction context: the histories a prediction was made with (a
+// checkpoint of the history state) and the table positions it read.
+// Training with the same context updates exactly those entries without
+// computing the indices again.
+typedef struct
+{
+  uint64_t ghistory;  // global history register
+  uint16_t lhistory;  // local history of the branch (tournament, custom)
+  uint8_t prediction; // predicted direction
+  uint8_t counter;    // state of the counter that provided the prediction
+  union
+  {
+    struct
+    {
+      uint32_t index;
+    } gshare;
+    struct
+    {
+      uint32_t gpt_index;
+      uint32_t cpt_index;
+      uint32_t lpt_index;
+    } tour;
+    struct
+    {
+      uint32_t lpt_index;
+      uint32_t set_index;
+      uint16_t tag;
+    } yags;
+    struct
+    {
+      uint32_t index[MAX_HYBRID_COMPONENTS]; // entry of every component
+      uint32_t chooser_index;
+      uint8_t predictions; // bit i: prediction of component i
+    } hybrid;
+  };
+} bp_context;
+
+// With speculative histories, predictions shift their predicted direction
+// into the global and local histories right away. Training a mispredicted
+// branch repairs them from its context; younger predictions made on
+// the wrong history must be squashed (youngest first) and made again.
+extern int spec_history;
+
+// Variants of make_prediction and train_predictor for deferred training:
+// the prediction fills 'ctx', which is handed back when training the
+// same branch
+//
+uint32_t make_prediction_ctx(uint32_t pc, uint32_t target, uint32_t direct, bp_context *ctx);
+void train_predictor_ctx(uint32_t pc, uint32_t target, uint32_t outcome, uint32_t condition, uint32_t call, uint32_t ret, uint32_t direct, const bp_context *ctx);
+
+// Fill 'lookups' with the entries the prediction made with 'ctx' for the
+// branch at PC 'pc' read
+//
+// Returns the number of entries
+//
+int context_lookups(uint32_t pc, const bp_context *ctx, bp_lookup *lookups);
+
+// Undo the speculative history update of a prediction that is thrown
+// away before it resolves
+//
+void squash_prediction(uint32_t pc, const bp_context *ctx);
+
+// Write the state of the initialized predictor to 'f', and restore it
+// from a snapshot taken with the same predictor configuration
+//
+// Returns True if Successful
+//
+int save_predictor(FILE *f);
+int load_predictor(FILE *f);
+
+// Structures flush_predictor resets, combined as a mask
+#define FLUSH_HISTORY 1 // global history and local history tables
+#define FLUSH_TABLES 2  // counter tables
+#define FLUSH_CHOOSER 4 // tournament choice table and hybrid chooser
+#define FLUSH_CACHES 8  // tagged caches of the custom (YAGS) predictor
+#define FLUSH_ALL 15
+
+// Reset the 'structures' of the initialized predictor to their initial
+// state, as a barrier flushing predictor state would
+//
+void flush_predictor(int structures);
 
 
 #endif
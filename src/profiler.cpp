@@ -0,0 +1,148 @@
+//========================================================//
+//  profiler.cpp                                          //
+//  Source file for the per-branch misprediction profiler //
+//                                                        //
+//  Static branches live in an open-addressing hash table //
+//  keyed by PC with linear probing                       //
+//========================================================//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "profiler.h"
+
+//------------------------------------//
+//      Profiler Data Structures      //
+//------------------------------------//
+
+typedef struct
+{
+  uint32_t pc;
+  uint32_t valid;
+  uint64_t executions;
+  uint64_t mispredictions;
+  uint64_t taken;
+} branch_profile;
+
+branch_profile *profile_table;
+int profile_bits;         // log2 of the number of slots
+uint32_t profile_used;    // number of occupied slots
+
+//------------------------------------//
+//        Profiler Functions          //
+//------------------------------------//
+
+// Fibonacci hashing spreads the word-aligned PCs over the slots
+//
+uint32_t profile_slot(uint32_t pc)
+{
+  return (uint32_t)(pc * 2654435769u) >> (32 - profile_bits);
+}
+
+void alloc_profile_table(int bits)
+{
+  profile_bits = bits;
+  profile_table = (branch_profile *)calloc((size_t)1 << bits, sizeof(branch_profile));
+  profile_used = 0;
+}
+
+branch_profile *find_profile(uint32_t pc)
+{
+  uint32_t mask = (1u << profile_bits) - 1;
+  uint32_t slot = profile_slot(pc);
+  while (profile_table[slot].valid && profile_table[slot].pc != pc)
+  {
+    slot = (slot + 1) & mask;
+  }
+  return &profile_table[slot];
+}
+
+// Double the table once it is half full to keep probe sequences short
+//
+void grow_profile_table()
+{
+  branch_profile *old_table = profile_table;
+  uint32_t old_entries = 1u << profile_bits;
+
+  alloc_profile_table(profile_bits + 1);
+  for (uint32_t i = 0; i < old_entries; i++)
+  {
+    if (old_table[i].valid)
+    {
+      *find_profile(old_table[i].pc) = old_table[i];
+      profile_used++;
+    }
+  }
+  free(old_table);
+}
+
+void init_profiler(int capacityBits)
+{
+  // Keep the load factor at or below one half from the start
+  alloc_profile_table(capacityBits + 1);
+}
+
+void profile_branch(uint32_t pc, uint32_t outcome, uint32_t prediction)
+{
+  branch_profile *entry = find_profile(pc);
+  if (!entry->valid)
+  {
+    if (2 * (profile_used + 1) > (1u << profile_bits))
+    {
+      grow_profile_table();
+      entry = find_profile(pc);
+    }
+    entry->valid = 1;
+    entry->pc = pc;
+    profile_used++;
+  }
+  entry->executions++;
+  entry->taken += outcome;
+  entry->mispredictions += (prediction != outcome);
+}
+
+int compare_mispredictions(const void *a, const void *b)
+{
+  const branch_profile *x = (const branch_profile *)a;
+  const branch_profile *y = (const branch_profile *)b;
+  if (x->mispredictions != y->mispredictions)
+    return (x->mispredictions < y->mispredictions) ? 1 : -1;
+  return (x->pc > y->pc) - (x->pc < y->pc);
+}
+
+void print_profile(int top_k, uint64_t total_mispredictions)
+{
+  // Rank a copy of the occupied slots so the table stays usable
+  uint32_t n = 0;
+  uint32_t entries = 1u << profile_bits;
+  branch_profile *ranked = (branch_profile *)malloc(profile_used * sizeof(branch_profile) + 1);
+  for (uint32_t i = 0; i < entries; i++)
+  {
+    if (profile_table[i].valid)
+    {
+      ranked[n++] = profile_table[i];
+    }
+  }
+  qsort(ranked, n, sizeof(branch_profile), compare_mispredictions);
+
+  printf("Static branches: %10u\n", n);
+  printf("Top %d mispredicted branches:\n", top_k);
+  printf("  %-10s  %12s  %12s  %7s  %7s  %7s\n", "PC", "Executions", "Incorrect", "Rate", "Taken%", "Share%");
+  for (uint32_t i = 0; i < n && i < (uint32_t)top_k; i++)
+  {
+    branch_profile *entry = &ranked[i];
+    if (entry->mispredictions == 0)
+      break;
+    printf("  0x%08x  %12llu  %12llu  %7.3f  %7.2f  %7.2f\n", entry->pc,
+           (unsigned long long)entry->executions,
+           (unsigned long long)entry->mispredictions,
+           1000 * ((float)entry->mispredictions / (float)entry->executions),
+           100 * ((float)entry->taken / (float)entry->executions),
+           100 * ((float)entry->mispredictions / (float)total_mispredictions));
+  }
+  free(ranked);
+}
+
+void cleanup_profiler()
+{
+  free(profile_table);
+}
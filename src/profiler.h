@@ -0,0 +1,30 @@
+//========================================================//
+//  profiler.h                                            //
+//  Header file for the per-branch misprediction profiler //
+//                                                        //
+//  Accounts executions, mispredictions and taken rate    //
+//  for every static conditional branch                   //
+//========================================================//
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+
+// Initialize the profiler with room for about 2^'capacityBits' static
+// branches; the table grows on demand
+//
+void init_profiler(int capacityBits);
+
+// Account one scored conditional branch
+//
+void profile_branch(uint32_t pc, uint32_t outcome, uint32_t prediction);
+
+// Print the 'top_k' branches with the most mispredictions, with their
+// share of 'total_mispredictions'
+//
+void print_profile(int top_k, uint64_t total_mispredictions);
+
+void cleanup_profiler();
+
+#endif
@@ -0,0 +1,105 @@
+//========================================================//
+//  results.cpp                                           //
+//  Source file for the results database                  //
+//                                                        //
+//  One tab-separated line per run: trace hash, build     //
+//  fingerprint, configuration key and the statistics     //
+//========================================================//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "results.h"
+
+#define FNV_OFFSET 0xcbf29ce484222325ull
+#define FNV_PRIME 0x100000001b3ull
+
+int hash_file(const char *path, uint64_t *hash)
+{
+  FILE *f = fopen(path, "rb");
+  if (f == NULL)
+    return 0;
+  unsigned char block[1 << 16];
+  uint64_t h = FNV_OFFSET;
+  size_t got;
+  while ((got = fread(block, 1, sizeof(block), f)) > 0)
+  {
+    for (size_t i = 0; i < got; i++)
+    {
+      h = (h ^ block[i]) * FNV_PRIME;
+    }
+  }
+  int ok = !ferror(f);
+  fclose(f);
+  *hash = h;
+  return ok;
+}
+
+int lookup_result(const char *db_path, uint64_t trace_hash, uint64_t build, const char *key,
+                  uint64_t *values, int n)
+{
+  FILE *f = fopen(db_path, "r");
+  if (f == NULL)
+    return 0;
+
+  char *line = NULL;
+  size_t line_len = 0;
+  size_t key_len = strlen(key);
+  int found = 0;
+  while (getline(&line, &line_len, f) != -1)
+  {
+    char *p = line;
+    if (strtoull(p, &p, 16) != trace_hash || *p++ != '\t')
+      continue;
+    if (strtoull(p, &p, 16) != build || *p++ != '\t')
+      continue;
+    if (strncmp(p, key, key_len) != 0 || p[key_len] != '\t')
+      continue;
+    p += key_len + 1;
+
+    // Later records of the same run replace earlier ones
+    uint64_t parsed[64];
+    int i;
+    for (i = 0; i < n && i < 64; i++)
+    {
+      char *end;
+      parsed[i] = strtoull(p, &end, 10);
+      if (end == p)
+        break;
+      p = end;
+    }
+    if (i == n && (*p == '\n' || *p == '\0'))
+    {
+      memcpy(values, parsed, n * sizeof(uint64_t));
+      found = 1;
+    }
+  }
+  free(line);
+  fclose(f);
+  return found;
+}
+
+int record_result(const char *db_path, uint64_t trace_hash, uint64_t build, const char *key,
+                  const uint64_t *values, int n)
+{
+  size_t size = strlen(key) + 64 + 21 * (size_t)n;
+  char *line = (char *)malloc(size);
+  int len = snprintf(line, size, "%016llx\t%016llx\t%s\t", (unsigned long long)trace_hash,
+                     (unsigned long long)build, key);
+  for (int i = 0; i < n; i++)
+  {
+    len += snprintf(line + len, size - len, i > 0 ? " %llu" : "%llu", (unsigned long long)values[i]);
+  }
+  line[len++] = '\n';
+
+  int ok = 0;
+  int fd = open(db_path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+  if (fd >= 0)
+  {
+    ok = write(fd, line, len) == len;
+    close(fd);
+  }
+  free(line);
+  return ok;
+}
@@ -0,0 +1,37 @@
+//========================================================//
+//  results.h                                             //
+//  Header file for the results database                  //
+//                                                        //
+//  An append-only file of run statistics keyed by trace  //
+//  content, build and run configuration                  //
+//========================================================//
+
+#ifndef RESULTS_H
+#define RESULTS_H
+
+#include <stdint.h>
+
+// Content hash (64-bit FNV-1a) of the file at 'path'
+//
+// Returns True if Successful
+//
+int hash_file(const char *path, uint64_t *hash);
+
+// Find the newest record of 'db_path' for the trace with content hash
+// 'trace_hash', simulated by the build with fingerprint 'build' with the
+// configuration 'key', and copy its 'n' values to 'values'
+//
+// Returns True if a record was found
+//
+int lookup_result(const char *db_path, uint64_t trace_hash, uint64_t build, const char *key,
+                  uint64_t *values, int n);
+
+// Append a record of 'n' values. Records are written with a single
+// append so that concurrent writers do not interleave.
+//
+// Returns True if Successful
+//
+int record_result(const char *db_path, uint64_t trace_hash, uint64_t build, const char *key,
+                  const uint64_t *values, int n);
+
+#endif
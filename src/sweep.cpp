@@ -0,0 +1,168 @@
+//========================================================//
+//  sweep.cpp                                             //
+//  Source file for multi-process sweeps                  //
+//                                                        //
+//  Each job runs in its own forked process, so a crashing//
+//  experimental predictor only loses its own job         //
+//========================================================//
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "sweep.h"
+
+// A worker process the coordinator is waiting for
+typedef struct
+{
+  pid_t pid;
+  int job;
+  double start;
+} running_job;
+
+double sweep_clock()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+void *shared_alloc(size_t bytes)
+{
+  void *p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  return (p == MAP_FAILED) ? NULL : p;
+}
+
+void shared_seal(void *p, size_t bytes)
+{
+  mprotect(p, bytes, PROT_READ);
+}
+
+void shared_free(void *p, size_t bytes)
+{
+  munmap(p, bytes);
+}
+
+// Each slot holds the status followed by the result, padded to a cache
+// line so workers never write to the same line
+//
+size_t job_slot_size(size_t result_size)
+{
+  return (sizeof(job_status) + result_size + 63) & ~(size_t)63;
+}
+
+job_status *job_slot(job_status *status, size_t result_size, int job)
+{
+  return (job_status *)((char *)status + job * job_slot_size(result_size));
+}
+
+void *job_result(job_status *status, size_t result_size, int job)
+{
+  return job_slot(status, result_size, job) + 1;
+}
+
+void free_sweep(job_status *status, int num_jobs, size_t result_size)
+{
+  shared_free(status, num_jobs * job_slot_size(result_size));
+}
+
+pid_t start_job(job_status *status, size_t result_size, int job, void (*run)(int, void *))
+{
+  job_status *slot = job_slot(status, result_size, job);
+  slot->attempts++;
+  slot->state = JOB_PENDING;
+  fflush(stdout);
+
+  pid_t pid = fork();
+  if (pid == 0)
+  {
+    double start = sweep_clock();
+    run(job, slot + 1);
+    slot->seconds = sweep_clock() - start;
+    // Publish the state only after the result is complete
+    __atomic_store_n(&slot->state, JOB_DONE, __ATOMIC_RELEASE);
+    fflush(stdout);
+    _exit(0);
+  }
+  return pid;
+}
+
+job_status *run_sweep(int num_jobs, int max_workers, double timeout, int retries,
+                      size_t result_size, void (*run)(int job, void *result))
+{
+  job_status *status = (job_status *)shared_alloc(num_jobs * job_slot_size(result_size));
+  if (status == NULL)
+    return NULL;
+  memset(status, 0, num_jobs * job_slot_size(result_size));
+  if (max_workers < 1)
+    max_workers = 1;
+
+  running_job *running = (running_job *)calloc(max_workers, sizeof(running_job));
+  int num_running = 0;
+  int next_job = 0;
+  int *retry_queue = (int *)malloc(num_jobs * sizeof(int));
+  int num_retries = 0;
+
+  while (next_job < num_jobs || num_retries > 0 || num_running > 0)
+  {
+    // Fill free worker slots, retries first
+    while (num_running < max_workers && (num_retries > 0 || next_job < num_jobs))
+    {
+      int job = (num_retries > 0) ? retry_queue[--num_retries] : next_job++;
+      pid_t pid = start_job(status, result_size, job, run);
+      if (pid < 0)
+      {
+        job_slot(status, result_size, job)->state = JOB_FAILED;
+        continue;
+      }
+      running[num_running].pid = pid;
+      running[num_running].job = job;
+      running[num_running].start = sweep_clock();
+      num_running++;
+    }
+
+    // Reap finished workers and kill the ones past their deadline
+    int reaped = 0;
+    for (int i = 0; i < num_running; i++)
+    {
+      int wstatus;
+      job_status *slot = job_slot(status, result_size, running[i].job);
+      pid_t done = waitpid(running[i].pid, &wstatus, WNOHANG);
+      int timed_out = 0;
+      if (done == 0)
+      {
+        if (timeout <= 0 || sweep_clock() - running[i].start < timeout)
+          continue;
+        kill(running[i].pid, SIGKILL);
+        waitpid(running[i].pid, &wstatus, 0);
+        timed_out = 1;
+      }
+
+      int ok = !timed_out && WIFEXITED(wstatus) && WEXITSTATUS(wstatus) == 0 &&
+               __atomic_load_n(&slot->state, __ATOMIC_ACQUIRE) == JOB_DONE;
+      if (!ok)
+      {
+        slot->seconds = sweep_clock() - running[i].start;
+        if (slot->attempts <= retries)
+          retry_queue[num_retries++] = running[i].job;
+        else
+          slot->state = timed_out ? JOB_TIMEOUT : JOB_FAILED;
+      }
+      running[i--] = running[--num_running];
+      reaped = 1;
+    }
+
+    if (!reaped && num_running > 0)
+    {
+      struct timespec pause = {0, 2000000};
+      nanosleep(&pause, NULL);
+    }
+  }
+
+  free(running);
+  free(retry_queue);
+  return status;
+}
@@ -0,0 +1,52 @@
+//========================================================//
+//  sweep.h                                               //
+//  Header file for multi-process sweeps                  //
+//                                                        //
+//  Runs independent jobs in forked worker processes that //
+//  report through a shared-memory results array          //
+//========================================================//
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <stddef.h>
+
+// Job states in the shared results array
+#define JOB_PENDING 0
+#define JOB_DONE 1
+#define JOB_FAILED 2  // crashed or exited with an error on every attempt
+#define JOB_TIMEOUT 3 // ran out of time on the last attempt
+
+// Per-job bookkeeping, followed in shared memory by the job's result
+typedef struct
+{
+  int state;       // written by the worker once its result is complete
+  int attempts;
+  double seconds;  // wall time of the last attempt
+} job_status;
+
+// Allocate a shared anonymous mapping that forked workers inherit, and
+// make one read-only once it has been filled in
+//
+// shared_alloc returns NULL on failure
+//
+void *shared_alloc(size_t bytes);
+void shared_seal(void *p, size_t bytes);
+void shared_free(void *p, size_t bytes);
+
+// Run jobs 0 .. num_jobs-1, each in its own forked worker with at most
+// 'max_workers' alive at once. A worker calls run(job, result) and exits;
+// 'result' points to 'result_size' bytes of shared memory for the job.
+// Workers that crash, exit non-zero or exceed 'timeout' seconds (none
+// when 0) are retried up to 'retries' times.
+//
+// Returns the shared results array; job_slot and job_result locate the
+// status and result of job j in it. Free it with free_sweep.
+//
+job_status *run_sweep(int num_jobs, int max_workers, double timeout, int retries,
+                      size_t result_size, void (*run)(int job, void *result));
+job_status *job_slot(job_status *status, size_t result_size, int job);
+void *job_result(job_status *status, size_t result_size, int job);
+void free_sweep(job_status *status, int num_jobs, size_t result_size);
+
+#endif
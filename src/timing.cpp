@@ -0,0 +1,156 @@
+//========================================================//
+//  timing.cpp                                            //
+//  Source file for the SRAM access time and area model   //
+//                                                        //
+//  A first-order CACTI-style model: the fastest split of //
+//  each structure into subarrays sets its access time    //
+//========================================================//
+#include <math.h>
+#include <stdio.h>
+#include "timing.h"
+#include "bank.h"
+
+//------------------------------------//
+//      Technology Parameters         //
+//------------------------------------//
+
+int techNode = 22;    // Feature size in nm
+double cycleTime = 0; // ps
+
+// Rules of thumb scaled by the feature size F. Wires are copper of width
+// F and height 2F; a 6T cell is 14F x 10F and every port beyond the first
+// adds a pair of bit lines and a word line to it.
+#define FO4_PS_PER_NM 0.36   // fanout-of-4 inverter delay
+#define RHO_OHM_UM 0.022     // copper resistivity
+#define WIRE_FF_PER_UM 0.2   // wire capacitance
+#define CELL_W_F 14.0
+#define CELL_H_F 10.0
+#define PORT_TRACK_F 4.0     // pitch of a port's wire
+#define DRAIN_FF_PER_NM 0.0045 // bit line load of a cell
+#define CELL_UA 40.0         // read current of a cell
+#define SENSE_SWING_V 0.05   // bit line swing the sense amplifiers need
+#define DECODER_W_F 60.0     // row decoder beside a subarray
+#define SENSE_H_F 100.0      // sense amplifiers and column mux below it
+#define FLOP_F2 600.0        // one bit of a history register
+
+#define MAX_SPLIT 64
+
+//------------------------------------//
+//        Timing Functions            //
+//------------------------------------//
+
+// Access time and area of an array of 'sets' sets of 'assoc' ways of
+// 'width' bits, split 'ndbl' ways along the bit lines and 'ndwl' ways
+// along the word lines with 'nspd' sets per row
+//
+void estimate_organization(uint32_t sets, uint32_t width, uint32_t assoc, uint32_t ports, int ndbl,
+                           int ndwl, int nspd, sram_estimate *est)
+{
+  double f_um = techNode / 1000.0;
+  double fo4 = FO4_PS_PER_NM * techNode;
+  double rc = RHO_OHM_UM / (2 * f_um * f_um) * WIRE_FF_PER_UM * 1e-3; // ps per um^2
+  double cell_w = (CELL_W_F + 2 * PORT_TRACK_F * (ports - 1)) * f_um;
+  double cell_h = (CELL_H_F + PORT_TRACK_F * (ports - 1)) * f_um;
+
+  double rows = ceil((double)sets / nspd / ndbl);
+  double cols = (double)width * assoc * nspd / ndwl;
+  double sub_w = cols * cell_w + DECODER_W_F * f_um;
+  double sub_h = rows * cell_h + SENSE_H_F * f_um;
+  double area_um2 = ndbl * ndwl * sub_w * sub_h;
+
+  // Decode, word line, bit line swing, sensing and column mux
+  double decode = fo4 * (3 + log2(rows) / 2);
+  double wordline = fo4 + 0.38 * rc * (cols * cell_w) * (cols * cell_w);
+  double bitline_ff = rows * (DRAIN_FF_PER_NM * techNode + WIRE_FF_PER_UM * cell_h);
+  double bitline = 1000 * bitline_ff * SENSE_SWING_V / CELL_UA;
+  double sense = 2 * fo4 + fo4 * log2(nspd) / 2;
+  // Tag compare and way select
+  double compare = (assoc > 1) ? fo4 * (2 + log2(assoc)) : 0;
+  // Address in and data out over repeated wires across the array
+  double route = sqrt(fo4 * rc) * sqrt(area_um2);
+
+  est->access_ps = decode + wordline + bitline + sense + compare + route;
+  est->area_mm2 = area_um2 * 1e-6;
+  est->subarrays = ndbl * ndwl;
+}
+
+void estimate_sram(const bp_table *table, sram_estimate *est)
+{
+  double f_um = techNode / 1000.0;
+  if (table->entries <= 1)
+  {
+    est->access_ps = FO4_PS_PER_NM * techNode;
+    est->area_mm2 = table->width * FLOP_F2 * f_um * f_um * 1e-6;
+    est->subarrays = 0;
+    return;
+  }
+
+  // Banked tables are that many smaller arrays
+  uint32_t banks = (numBanks > 0) ? numBanks : 1;
+  uint32_t ports = (numBanks > 0 && (uint32_t)bankPorts > table->ports) ? bankPorts : table->ports;
+  uint32_t sets = (table->entries / table->assoc + banks - 1) / banks;
+
+  est->access_ps = 0;
+  for (int nspd = 1; nspd <= MAX_SPLIT && (uint32_t)nspd <= sets; nspd *= 2)
+  {
+    for (int ndbl = 1; ndbl <= MAX_SPLIT && (uint32_t)(ndbl * nspd) <= sets; ndbl *= 2)
+    {
+      for (int ndwl = 1; ndwl <= MAX_SPLIT && (uint32_t)ndwl <= table->width * table->assoc * nspd;
+           ndwl *= 2)
+      {
+        sram_estimate e;
+        estimate_organization(sets, table->width, table->assoc, ports, ndbl, ndwl, nspd, &e);
+        if (est->access_ps == 0 || e.access_ps < est->access_ps ||
+            (e.access_ps == est->access_ps && e.area_mm2 < est->area_mm2))
+        {
+          *est = e;
+        }
+      }
+    }
+  }
+  est->area_mm2 *= banks;
+  est->subarrays *= banks;
+}
+
+double predictor_access_time(const char **slowest)
+{
+  bp_table tables[MAX_BP_TABLES];
+  int n = declare_tables(tables);
+  double worst = 0;
+  for (int i = 0; i < n; i++)
+  {
+    sram_estimate est;
+    estimate_sram(&tables[i], &est);
+    if (est.access_ps > worst)
+    {
+      worst = est.access_ps;
+      if (slowest != NULL)
+        *slowest = tables[i].name;
+    }
+  }
+  return worst;
+}
+
+void print_timing()
+{
+  bp_table tables[MAX_BP_TABLES];
+  int n = declare_tables(tables);
+  double area = 0;
+  printf("Timing:          %d nm\n", techNode);
+  printf("  %-18s  %9s  %9s  %9s\n", "Structure", "Subarrays", "Access ps", "Area mm2");
+  for (int i = 0; i < n; i++)
+  {
+    sram_estimate est;
+    estimate_sram(&tables[i], &est);
+    area += est.area_mm2;
+    printf("  %-18s  %9d  %9.1f  %9.4f\n", tables[i].name, est.subarrays, est.access_ps, est.area_mm2);
+  }
+  const char *slowest = "-";
+  double access = predictor_access_time(&slowest);
+  printf("Access time:        %7.1f ps (%s)\n", access, slowest);
+  printf("Area:               %7.4f mm2\n", area);
+  if (cycleTime > 0)
+  {
+    printf("Cycle time:         %7.1f ps (%s)\n", cycleTime, (access > cycleTime) ? "exceeded" : "met");
+  }
+}
@@ -0,0 +1,39 @@
+//========================================================//
+//  timing.h                                              //
+//  Header file for the SRAM access time and area model   //
+//                                                        //
+//  Estimates every declared structure of the configured  //
+//  predictor at a technology node                        //
+//========================================================//
+
+#ifndef TIMING_H
+#define TIMING_H
+
+#include "predictor.h"
+
+extern int techNode;     // feature size in nm
+extern double cycleTime; // ps (no timing constraint when 0)
+
+// Estimated access of one structure, the fastest of its organizations
+typedef struct
+{
+  double access_ps;
+  double area_mm2;
+  int subarrays;
+} sram_estimate;
+
+// Estimate a structure of the configured predictor, split into banks
+// when the banked table model is enabled
+//
+void estimate_sram(const bp_table *table, sram_estimate *est);
+
+// Access time of the slowest structure of the configured predictor in
+// ps, with its name in 'slowest' when not NULL
+//
+double predictor_access_time(const char **slowest);
+
+// Print the access time and area of every structure and the total
+//
+void print_timing();
+
+#endif
@@ -0,0 +1,102 @@
+//========================================================//
+//  trace.cpp                                             //
+//  Source file for trace input                           //
+//                                                        //
+//  Opens (possibly compressed) branch traces and reads   //
+//  the "!!!" summary lines of their .txt sidecar files   //
+//========================================================//
+#include <stdlib.h>
+#include <string.h>
+#include "trace.h"
+
+int has_suffix(const char *s, const char *suffix)
+{
+  size_t n = strlen(s), m = strlen(suffix);
+  return n >= m && !strcmp(s + n - m, suffix);
+}
+
+FILE *open_trace(const char *path)
+{
+  if (has_suffix(path, ".bz2"))
+  {
+    // Hand the decompression to bunzip2, the same as piping it in
+    char cmd[4096];
+    if (strchr(path, '\'') != NULL || strlen(path) + 16 > sizeof(cmd))
+      return NULL;
+    snprintf(cmd, sizeof(cmd), "bunzip2 -kc '%s'", path);
+    return popen(cmd, "r");
+  }
+  return fopen(path, "r");
+}
+
+void close_trace(FILE *f, const char *path)
+{
+  if (path != NULL && has_suffix(path, ".bz2"))
+    pclose(f);
+  else
+    fclose(f);
+}
+
+int parse_info_line(const char *line, trace_info *info)
+{
+  char name[64];
+  unsigned long long value;
+  if (strncmp(line, "!!!", 3) != 0)
+    return 0;
+  if (sscanf(line, "!!! Number of %63[^=]= %llu", name, &value) != 2)
+    return 1;
+
+  if (!strncmp(name, "Instructions", 12))
+    info->instructions = value;
+  else if (!strncmp(name, "Unconditional branches", 22))
+    info->unconditional = value;
+  else if (!strncmp(name, "Conditional branches", 20))
+    info->conditional = value;
+  else if (!strncmp(name, "Call branches", 13))
+    info->calls = value;
+  else if (!strncmp(name, "Ret branches", 12))
+    info->returns = value;
+  return 1;
+}
+
+int is_event_line(const char *line)
+{
+  return !strncmp(line, "!!!", 3) && strncmp(line, "!!! Number of ", 14) != 0;
+}
+
+int read_trace_info(const char *path, trace_info *info)
+{
+  FILE *f = fopen(path, "r");
+  if (f == NULL)
+    return 0;
+
+  // Summary lines only ever appear at the head of the file
+  char line[256];
+  int found = 0;
+  while (fgets(line, sizeof(line), f) != NULL && parse_info_line(line, info))
+  {
+    found = 1;
+  }
+  fclose(f);
+  return found;
+}
+
+int read_sidecar(const char *trace_path, trace_info *info)
+{
+  char path[4096];
+  size_t n = strlen(trace_path);
+  if (n + 5 > sizeof(path))
+    return 0;
+  strcpy(path, trace_path);
+
+  // Strip the extension of the file name (not of a directory)
+  char *dot = strrchr(path, '.');
+  char *slash = strrchr(path, '/');
+  if (dot != NULL && (slash == NULL || dot > slash))
+    *dot = '\0';
+  strcat(path, ".txt");
+
+  if (!strcmp(path, trace_path))
+    return 0;
+  return read_trace_info(path, info);
+}
@@ -0,0 +1,59 @@
+//========================================================//
+//  trace.h                                               //
+//  Header file for trace input                           //
+//                                                        //
+//  Opens (possibly compressed) branch traces and reads   //
+//  the "!!!" summary lines of their .txt sidecar files   //
+//========================================================//
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Totals from the "!!! Number of ... = N" summary lines of a trace
+// (0 when unknown)
+typedef struct
+{
+  uint64_t instructions;
+  uint64_t unconditional;
+  uint64_t conditional;
+  uint64_t calls;
+  uint64_t returns;
+} trace_info;
+
+// Open a trace file for reading; files ending in .bz2 are decompressed
+// through bunzip2
+//
+// Returns NULL on failure
+//
+FILE *open_trace(const char *path);
+void close_trace(FILE *f, const char *path);
+
+// Parse one "!!!" summary line into 'info'
+//
+// Returns True if the line was a summary line
+//
+int parse_info_line(const char *line, trace_info *info);
+
+// Other "!!!" lines mark events in the trace, e.g. "!!! Context switch"
+//
+// Returns True if the line marks an event
+//
+int is_event_line(const char *line);
+
+// Read the summary lines at the head of 'path'
+//
+// Returns True if at least one summary line was found
+//
+int read_trace_info(const char *path, trace_info *info);
+
+// Read the sidecar of 'trace_path', i.e. the file with the trace's
+// extension (.bz2, .gz, ...) replaced by .txt
+//
+// Returns True if the sidecar was found and had summary lines
+//
+int read_sidecar(const char *trace_path, trace_info *info);
+
+#endif